@@ -2,385 +2,1170 @@
 #include "Game.h"
 #include "globals.h"
 #include <iostream>
+#include <string>
 #include <vector>
+#include <cstdint>
 
 using namespace std;
 
+// BoardImpl is the interface Board delegates to.  Common board sizes get a
+// FixedBoardImpl whose dimensions are compile-time constants; everything
+// else uses the runtime-sized DynamicBoardImpl.
 class BoardImpl
 {
 public:
     BoardImpl(const Game& g);
-    void clear();
-    void block();
-    void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
-    void display(bool shotsOnly) const;
-    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
-    bool allShipsDestroyed() const;
+    virtual ~BoardImpl() {}
+    virtual void clear() = 0;
+    void reset();
+    virtual void block(double fraction) = 0;
+    virtual void unblock() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    void display(bool shotsOnly, ostream& out) const;
+    void redisplay(bool shotsOnly, ostream& out) const;
+    void prepareDisplay() const;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual int attackBatch(const Point* shots, int n, ShotResult* results) = 0;
+    virtual bool allShipsDestroyed() const = 0;
+    virtual int shipsAfloat() const = 0;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const = 0;
+    virtual bool isFree(Point p) const = 0;
+    virtual void save(BoardSnapshot& s) const = 0;
+    virtual bool restore(const BoardSnapshot& s) = 0;
+    void pushUndo() { m_levels.push_back(m_changes.size()); }
+    bool popUndo();
+
+protected:
+    // A successful attack, placeShip or unplaceShip, as the undo log
+    // records it
+    struct Change
+    {
+        enum Kind { ATTACK, PLACE, UNPLACE };
+        Change(Kind k, Point pt, int id, Direction d) : kind(k), p(pt), shipId(id), dir(d) {}
+        Kind kind;
+        Point p;
+        int shipId;
+        Direction dir;
+    };
 
-private:
-    // TODO:  Decide what private members you need.  Here's one that's likely
-    //        to be useful:
     const Game& m_game;
-    char game_board[MAXROWS][MAXCOLS];
-    vector<int> placed_ships; 
-    vector<Point> attacked_positions; 
+    int m_rows;
+    int m_cols;
+    vector<int> m_order;    // always some permutation of the cell indexes
+    vector<Change> m_changes;   // undo log, oldest first
+    vector<int> m_levels;       // size of m_changes at each open pushUndo
+
+    void logChange(Change::Kind kind, Point p, int shipId, Direction dir)
+    {
+        if (!m_levels.empty())
+            m_changes.push_back(Change(kind, p, shipId, dir));
+    }
+    void discardUndo()
+    {
+        m_changes.clear();
+        m_levels.clear();
+    }
+    // Take back the last attack, which was at p
+    virtual void unattack(Point p) = 0;
+    // Put back a ship that unplaceShip took off, even over cells that
+    // were attacked since it was placed
+    virtual void replaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
+
+    // A snapshot holds the blocked cells and then the attacked cells as
+    // bit masks, followed by each ship's first cell times two, plus one if
+    // it runs down, two ships to a word and all ones for a ship not placed
+    int maskWords() const { return (m_rows * m_cols + 63) / 64; }
+    int snapshotSize() const;
+    uint64_t* snapshotWords(BoardSnapshot& s) const;
+    // null if s was saved from a board of another size or fleet
+    const uint64_t* snapshotWords(const BoardSnapshot& s) const;
+    // Hash of the number of ships and each one's length
+    uint64_t fleetHash() const;
+    static void packShip(uint64_t* ships, int shipId, int cell, bool down);
+    // false if the ship is not placed
+    static bool unpackShip(const uint64_t* ships, int shipId, int& cell, bool& down);
+
+    // Characters shown for the cells of a row by display(), one call per
+    // row rather than per cell
+    virtual void rowSymbols(int row, bool shotsOnly, char* symbols) const = 0;
+    // The text of the last frame displayed, built on first use and then
+    // only updated cell by cell; where that frame went and how it showed
+    // the board; and the escape sequences of a redisplay
+    mutable string m_frame;
+    mutable const ostream* m_shownOn;
+    mutable bool m_shownShotsOnly;
+    mutable string m_patch;
+    mutable string m_row;       // a row's symbols, for redisplay to compare
+    mutable int m_frameLine;    // bytes per line of the frame, newline included
+    // Offset of a cell in the frame, below the column labels
+    int frameCell(int cell) const
+        { return (1 + cell / m_cols) * m_frameLine + m_frameLine - 1 - m_cols + cell % m_cols; }
+    void buildFrame() const;
+    // Number of cells block(fraction) marks, rounded down
+    int blockCount(double fraction) const;
+    // Move a uniformly random set of k cells to the front of m_order
+    void pickCells(int k);
 };
 
-BoardImpl::BoardImpl(const Game& g) : m_game(g)
+BoardImpl::BoardImpl(const Game& g)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()), m_order(g.rows() * g.cols()),
+      m_shownOn(nullptr), m_shownShotsOnly(false), m_frameLine(0)
+{
+    for (size_t k = 0; k < m_order.size(); k++)
+        m_order[k] = k;
+}
+
+void BoardImpl::reset()
+{
+    clear();
+    //block() draws from m_order as it stands, so a reused board must
+    //start from the same order as a new one
+    for (size_t k = 0; k < m_order.size(); k++)
+        m_order[k] = k;
+    m_shownOn = nullptr;
+}
+
+int BoardImpl::blockCount(double fraction) const
+{
+    int total = m_order.size();
+    if (!(fraction > 0))
+        return 0;
+    if (fraction >= 1)
+        return total;
+    return static_cast<int>(fraction * total);
+}
+
+bool BoardImpl::popUndo()
 {
-    for (int r = 0; r < m_game.rows(); r++)
+    if (m_levels.empty())
+        return false;
+    size_t mark = m_levels.back();
+    m_levels.pop_back();
+    //the reverse operations below must not be logged themselves
+    vector<int> open;
+    open.swap(m_levels);
+    while (m_changes.size() > mark)
     {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            game_board[r][c] = '.'; 
-        }
+        Change c = m_changes.back();
+        m_changes.pop_back();
+        if (c.kind == Change::ATTACK)
+            unattack(c.p);
+        else if (c.kind == Change::PLACE)
+            unplaceShip(c.p, c.shipId, c.dir);
+        else
+            replaceShip(c.p, c.shipId, c.dir);
     }
+    open.swap(m_levels);
+    return true;
+}
+
+int BoardImpl::snapshotSize() const
+{
+    return 2 * maskWords() + (m_game.nShips() + 1) / 2;
 }
 
-void BoardImpl::clear()
+uint64_t* BoardImpl::snapshotWords(BoardSnapshot& s) const
 {
-    for (int r = 0; r < m_game.rows(); r++)
+    int size = snapshotSize();
+    s.m_fleet = fleetHash();
+    s.m_rows = m_rows;
+    s.m_cols = m_cols;
+    s.m_size = size;
+    if (size <= BoardSnapshot::INLINE_WORDS)
     {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-                game_board[r][c] = '.';
-        }
+        s.m_spill.clear();
+        return s.m_inline;
     }
+    s.m_spill.assign(size, 0);
+    return &s.m_spill[0];
+}
+
+const uint64_t* BoardImpl::snapshotWords(const BoardSnapshot& s) const
+{
+    int size = snapshotSize();
+    if (s.m_rows != m_rows || s.m_cols != m_cols || s.m_size != size || s.m_fleet != fleetHash())
+        return nullptr;
+    return (size <= BoardSnapshot::INLINE_WORDS ? s.m_inline : &s.m_spill[0]);
+}
+
+uint64_t BoardImpl::fleetHash() const
+{
+    //FNV-1a over the ship count and lengths
+    uint64_t h = 14695981039346656037ULL;
+    h = (h ^ uint64_t(m_game.nShips())) * 1099511628211ULL;
+    for (int id = 0; id < m_game.nShips(); id++)
+        h = (h ^ uint64_t(m_game.shipLength(id))) * 1099511628211ULL;
+    return h;
+}
+
+void BoardImpl::packShip(uint64_t* ships, int shipId, int cell, bool down)
+{
+    uint64_t code = (cell < 0 ? 0xFFFFFFFFULL : uint64_t(cell) * 2 + down);
+    int shift = 32 * (shipId & 1);
+    uint64_t& word = ships[shipId / 2];
+    word = (word & ~(0xFFFFFFFFULL << shift)) | (code << shift);
+}
+
+bool BoardImpl::unpackShip(const uint64_t* ships, int shipId, int& cell, bool& down)
+{
+    uint64_t code = (ships[shipId / 2] >> (32 * (shipId & 1))) & 0xFFFFFFFFULL;
+    if (code == 0xFFFFFFFFULL)
+        return false;
+    cell = code / 2;
+    down = code & 1;
+    return true;
+}
+
+void BoardImpl::pickCells(int k)
+{
+    // Partial Fisher-Yates: k random numbers, no pass over the board.  Any
+    // starting permutation gives a uniform subset, so m_order is not reset
+    // between calls.
+    int total = m_order.size();
+    for (int j = 0; j < k; j++)
+        swap(m_order[j], m_order[j + m_game.randInt(total - j)]);
 }
 
-void BoardImpl::block()
+// Lay out the labels of the frame once; the cells are filled in by display
+void BoardImpl::buildFrame() const
 {
-    int total_cells = m_game.rows() * m_game.cols(); 
-    int blocked_cells = 0; 
-    // Block cells with 50% probability
-    while (blocked_cells != (total_cells / 2))
+    // Row labels are padded to the widest row number; column labels show
+    // the last digit only so wide boards stay aligned
+    int labelWidth = to_string(m_rows - 1).size();
+    int line = labelWidth + 1 + m_cols + 1;
+    m_frameLine = line;
+    m_frame.assign((m_rows + 1) * line, ' ');
+    for (int t = 0; t < m_cols; t++)
+        m_frame[labelWidth + 1 + t] = '0' + t % 10;
+    for (int m = 0; m <= m_rows; m++)
     {
-        for (int r = 0; r < m_game.rows(); r++)
-        {
-            for (int c = 0; c < m_game.cols(); c++)
-            {
-                if (blocked_cells != (total_cells / 2))
-                {
-                    if ((randInt(2) == 0) && (game_board[r][c] != '#'))
-                    {
-                        game_board[r][c] = '#';
-                        blocked_cells++;
-                    }
-                }
-            }
-        }
+        m_frame[m * line + line - 1] = '\n';
+        if (m == m_rows)
+            break;
+        string label = to_string(m);
+        m_frame.replace((m + 1) * line + labelWidth - label.size(), label.size(), label);
     }
 }
 
-void BoardImpl::unblock()
+void BoardImpl::prepareDisplay() const
+{
+    if (m_frame.empty())
+        buildFrame();
+    m_patch.reserve(m_rows * 16 + m_cols * 8);
+    m_row.reserve(m_cols);
+}
+
+void BoardImpl::display(bool shotsOnly, ostream& out) const
+{
+    if (m_frame.empty())
+        buildFrame();
+    for (int m = 0; m < m_rows; m++)
+        rowSymbols(m, shotsOnly, &m_frame[frameCell(m * m_cols)]);
+    //one write for the whole frame rather than a flush per line
+    out.write(m_frame.data(), m_frame.size());
+    m_shownOn = &out;
+    m_shownShotsOnly = shotsOnly;
+}
+
+// Append the ANSI control sequence ESC [ n command
+static void appendEscape(string& s, int n, char command)
+{
+    char digits[12];
+    int nDigits = 0;
+    do
+    {
+        digits[nDigits++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    s += "\x1b[";
+    while (nDigits > 0)
+        s += digits[--nDigits];
+    s += command;
+}
+
+void BoardImpl::redisplay(bool shotsOnly, ostream& out) const
 {
-    for (int r = 0; r < m_game.rows(); r++)
+    if (m_shownOn != &out || m_shownShotsOnly != shotsOnly)
+    {
+        display(shotsOnly, out);
+        return;
+    }
+    //the cursor is at the start of the line below the frame; for each row
+    //with changes, go up to it, rewrite the changed cells by column, and
+    //come back down
+    m_patch.clear();
+    int firstColumn = m_frameLine - 1 - m_cols;
+    m_row.resize(m_cols);
+    for (int m = 0; m < m_rows; m++)
     {
-        for (int c = 0; c < m_game.cols(); c++)
+        bool rowChanged = false;
+        char* line = &m_frame[frameCell(m * m_cols)];
+        rowSymbols(m, shotsOnly, &m_row[0]);
+        if (m_row.compare(0, m_cols, line, m_cols) == 0)
+            continue;
+        for (int k = 0; k < m_cols; k++)
         {
-            if (game_board[r][c] == '#')
-                game_board[r][c] = '.';
+            char symbol = m_row[k];
+            if (symbol == line[k])
+                continue;
+            line[k] = symbol;
+            if (!rowChanged)
+                appendEscape(m_patch, m_rows - m, 'A');
+            rowChanged = true;
+            appendEscape(m_patch, firstColumn + k + 1, 'G');
+            m_patch += symbol;
+        }
+        if (rowChanged)
+        {
+            appendEscape(m_patch, m_rows - m, 'B');
+            m_patch += '\r';
         }
     }
+    if (!m_patch.empty())
+        out.write(m_patch.data(), m_patch.size());
+}
+
+//*********************************************************************
+//  DynamicBoardImpl
+//*********************************************************************
+
+// Per-cell state, stored row-major (r * cols + c) in one buffer sized when
+// the board is constructed
+struct Cell
+{
+    enum { BLOCKED = 1, HIT = 2, MISS = 4, ATTACKED = HIT | MISS };
+    int shipId;             // -1 if no ship covers the cell
+    unsigned char flags;
+};
+
+class DynamicBoardImpl : public BoardImpl
+{
+public:
+    DynamicBoardImpl(const Game& g);
+    virtual void clear();
+    virtual void block(double fraction);
+    virtual void unblock();
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    virtual int attackBatch(const Point* shots, int n, ShotResult* results);
+    virtual bool allShipsDestroyed() const;
+    virtual int shipsAfloat() const;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    virtual bool isFree(Point p) const;
+    virtual void save(BoardSnapshot& s) const;
+    virtual bool restore(const BoardSnapshot& s);
+
+private:
+    // Where a ship sits on the board and how many of its cells were hit
+    struct ShipState
+    {
+        ShipState() : placed(false), dir(HORIZONTAL), hits(0) {}
+        bool placed;
+        Point topOrLeft;
+        Direction dir;
+        int hits;
+    };
+
+    vector<Cell> m_cells;
+    vector<ShipState> m_ships;
+    int m_segmentsLeft;                 // unhit cells of placed ships
+    vector<Point> attacked_positions;   // shot history in order, for replay
+
+    int cellIndex(Point p) const { return p.r * m_cols + p.c; }
+    bool fits(Point topOrLeft, int length, Direction dir) const;
+    char cellSymbol(int cell, bool shotsOnly) const;
+    virtual void rowSymbols(int row, bool shotsOnly, char* symbols) const;
+    virtual void unattack(Point p);
+    virtual void replaceShip(Point topOrLeft, int shipId, Direction dir);
+};
+
+DynamicBoardImpl::DynamicBoardImpl(const Game& g)
+    : BoardImpl(g), m_cells(g.rows() * g.cols()), m_ships(g.nShips()), m_segmentsLeft(0)
+{
+    attacked_positions.reserve(m_cells.size());
+    clear();
+}
+
+void DynamicBoardImpl::clear()
+{
+    for (size_t k = 0; k < m_cells.size(); k++)
+    {
+        m_cells[k].shipId = -1;
+        m_cells[k].flags = 0;
+    }
+    for (size_t s = 0; s < m_ships.size(); s++)
+        m_ships[s] = ShipState();
+    m_segmentsLeft = 0;
+    attacked_positions.clear();
+    discardUndo();
+}
+
+void DynamicBoardImpl::block(double fraction)
+{
+    int total = m_cells.size();
+    int nBlocked = blockCount(fraction);
+    //pick whichever of the blocked and the open cells are fewer
+    bool pickBlocked = (nBlocked <= total - nBlocked);
+    int nPicked = (pickBlocked ? nBlocked : total - nBlocked);
+    pickCells(nPicked);
+    for (int cell = 0; cell < total; cell++)
+    {
+        if (pickBlocked)
+            m_cells[cell].flags &= ~Cell::BLOCKED;
+        else
+            m_cells[cell].flags |= Cell::BLOCKED;
+    }
+    for (int j = 0; j < nPicked; j++)
+        m_cells[m_order[j]].flags ^= Cell::BLOCKED;
+}
+
+void DynamicBoardImpl::unblock()
+{
+    for (size_t k = 0; k < m_cells.size(); k++)
+        m_cells[k].flags &= ~Cell::BLOCKED;
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+// Would a ship of the given length starting at topOrLeft stay on the board?
+bool DynamicBoardImpl::fits(Point topOrLeft, int length, Direction dir) const
+{
+    if (topOrLeft.r < 0 || topOrLeft.c < 0 || topOrLeft.r >= m_rows || topOrLeft.c >= m_cols)
+        return false;
+    if (dir == HORIZONTAL)
+        return topOrLeft.c + length <= m_cols;
+    return topOrLeft.r + length <= m_rows;
+}
+
+bool DynamicBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
    //validate shipId
     if (shipId < 0 || shipId >= m_game.nShips())
         return false; 
-    //make sure point is valid 
-    if (topOrLeft.r < 0 || topOrLeft.c < 0 || topOrLeft.r >= m_game.rows() || topOrLeft.c >= m_game.cols())
-        return false; 
-    //make sure ship is not placed outside board 
-    if (dir == HORIZONTAL && ((topOrLeft.c + m_game.shipLength(shipId)) <= m_game.cols()))
+    if (shipId >= static_cast<int>(m_ships.size()))
+        m_ships.resize(m_game.nShips());
+    //make sure ship has not previously been placed already on the board 
+    if (m_ships[shipId].placed)
+        return false;
+    //make sure point is valid and ship is not placed outside board 
+    int length = m_game.shipLength(shipId);
+    if (!fits(topOrLeft, length, dir))
+        return false;
+    //make sure there is no overlap on anything (other ships, blocked positions, shots)
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    int start = cellIndex(topOrLeft);
+    for (int k = 0, cell = start; k < length; k++, cell += step)
     {
-        //make sure there is no overlap on anything (other ships, blocked positions)
-        for (int t = topOrLeft.c; t < (topOrLeft.c + m_game.shipLength(shipId)); t++)
-        {
-            if (game_board[topOrLeft.r][t] != '.')
-                return false; 
-        }
+        if (m_cells[cell].shipId != -1 || m_cells[cell].flags != 0)
+            return false;
+    }
+    for (int k = 0, cell = start; k < length; k++, cell += step)
+        m_cells[cell].shipId = shipId;
+    ShipState& ship = m_ships[shipId];
+    ship.placed = true;
+    ship.topOrLeft = topOrLeft;
+    ship.dir = dir;
+    ship.hits = 0;
+    m_segmentsLeft += length;
+    logChange(Change::PLACE, topOrLeft, shipId, dir);
+    return true;
+}
 
-        if (placed_ships.size() == 0)
-        {
-            placed_ships.push_back(shipId);
-            for (int m = topOrLeft.c; m < (topOrLeft.c + m_game.shipLength(shipId)); m++)
-            {
-                game_board[topOrLeft.r][m] = m_game.shipSymbol(shipId); 
-            }
-            return true; 
-        }
-        //make sure ship has not previously been placed already on the board 
-        for (int k = 0; k < placed_ships.size(); k++)
-        {
-            if (shipId == placed_ships[k])
-                return false; 
-        }
-        placed_ships.push_back(shipId);
-        for (int m = topOrLeft.c; m < (topOrLeft.c + m_game.shipLength(shipId)); m++)
-        {
-            game_board[topOrLeft.r][m] = m_game.shipSymbol(shipId);
-        }
+bool DynamicBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    //check if such a shipId has been placed on the board
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()) || !m_ships[shipId].placed)
+        return false;
+    //the ship must lie exactly at the given point and direction
+    ShipState& ship = m_ships[shipId];
+    int length = m_game.shipLength(shipId);
+    if ((length > 1 && ship.dir != dir) || ship.topOrLeft.r != topOrLeft.r || ship.topOrLeft.c != topOrLeft.c)
+        return false;
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int k = 0, cell = cellIndex(topOrLeft); k < length; k++, cell += step)
+        m_cells[cell].shipId = -1;
+    m_segmentsLeft -= length - ship.hits;
+    ship = ShipState();
+    logChange(Change::UNPLACE, topOrLeft, shipId, dir);
+    return true;
+}
+
+char DynamicBoardImpl::cellSymbol(int index, bool shotsOnly) const
+{
+    const Cell& cell = m_cells[index];
+    if (cell.flags & Cell::HIT)
+        return 'X';
+    if (cell.flags & Cell::MISS)
+        return 'o';
+    if (shotsOnly)
+        return '.';
+    if (cell.shipId != -1)
+        return m_game.shipSymbol(cell.shipId);
+    if (cell.flags & Cell::BLOCKED)
+        return '#';
+    return '.';
+}
+
+void DynamicBoardImpl::rowSymbols(int row, bool shotsOnly, char* symbols) const
+{
+    for (int k = 0; k < m_cols; k++)
+        symbols[k] = cellSymbol(row * m_cols + k, shotsOnly);
+}
+
+bool DynamicBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+{
+    //check to see if board even contains coordinate 
+    if (p.r < 0 || p.c < 0 || p.r >= m_rows || p.c >= m_cols)
+        return false;
+    Cell& cell = m_cells[cellIndex(p)];
+    //location has been hit previously so return false 
+    if (cell.flags & Cell::ATTACKED)
+        return false;
+    attacked_positions.push_back(p);
+    logChange(Change::ATTACK, p, -1, HORIZONTAL);
+    //missed attack 
+    if (cell.shipId == -1)
+    {
+        cell.flags |= Cell::MISS;
+        shipDestroyed = false;
+        shotHit = false;
         return true;
     }
+    //boat has been hit; it is destroyed once all its cells are hits
+    cell.flags |= Cell::HIT;
+    m_segmentsLeft--;
+    shotHit = true;
+    shipDestroyed = (++m_ships[cell.shipId].hits == m_game.shipLength(cell.shipId));
+    if (shipDestroyed)
+        shipId = cell.shipId;
+    return true;
+}
 
-    if (dir == VERTICAL && ((topOrLeft.r + m_game.shipLength(shipId)) <= m_game.rows()))
+// Cells here are looked up one at a time anyway, so the shots are simply
+// attacked in order
+int DynamicBoardImpl::attackBatch(const Point* shots, int n, ShotResult* results)
+{
+    int nValid = 0;
+    for (int k = 0; k < n; k++)
     {
-        //make sure there is no overlap on anything (other ships, blocked positions)
-        for (int t = topOrLeft.r; t < (topOrLeft.r + m_game.shipLength(shipId)); t++)
-        {
-            if (game_board[t][topOrLeft.c] != '.')
-                return false;
-        }
+        ShotResult& r = results[k];
+        r.hit = false;
+        r.destroyed = false;
+        r.shipId = -1;
+        r.valid = DynamicBoardImpl::attack(shots[k], r.hit, r.destroyed, r.shipId);
+        if (r.valid)
+            nValid++;
+    }
+    return nValid;
+}
 
-        if (placed_ships.size() == 0)
-        {
-            placed_ships.push_back(shipId);
-            for (int m = topOrLeft.r; m < (topOrLeft.r + m_game.shipLength(shipId)); m++)
-            {
-                game_board[m][topOrLeft.c] = m_game.shipSymbol(shipId);
-            }
-            return true;
-        }
-        //make sure ship has not previously been placed already on the board 
-        for (int k = 0; k < placed_ships.size(); k++)
-        {
-            if (shipId == placed_ships[k])
-                return false;
-        }
-        placed_ships.push_back(shipId);
-        for (int m = topOrLeft.r; m < (topOrLeft.r + m_game.shipLength(shipId)); m++)
-        {
-            game_board[m][topOrLeft.c] = m_game.shipSymbol(shipId);
-        }
-        return true;
+bool DynamicBoardImpl::allShipsDestroyed() const
+{
+    return m_segmentsLeft == 0;
+}
+
+int DynamicBoardImpl::shipsAfloat() const
+{
+    int afloat = 0;
+    for (size_t s = 0; s < m_ships.size(); s++)
+    {
+        if (m_ships[s].placed && m_ships[s].hits < m_game.shipLength(s))
+            afloat++;
     }
-    return false; 
+    return afloat;
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool DynamicBoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
 {
-    bool ShipFound = false; 
-    vector<int>::iterator ship_location = placed_ships.begin();
-    if (placed_ships.size() == 0)
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()) || !m_ships[shipId].placed)
         return false;
-    //check if such a shipId has been placed on the board
-    for (int k = 0; k < placed_ships.size(); k++, ship_location++)
+    topOrLeft = m_ships[shipId].topOrLeft;
+    dir = m_ships[shipId].dir;
+    return true;
+}
+
+bool DynamicBoardImpl::isFree(Point p) const
+{
+    if (!m_game.isValid(p))
+        return false;
+    const Cell& cell = m_cells[cellIndex(p)];
+    return cell.shipId < 0 && !(cell.flags & Cell::BLOCKED);
+}
+
+void DynamicBoardImpl::unattack(Point p)
+{
+    Cell& cell = m_cells[cellIndex(p)];
+    if (cell.flags & Cell::HIT)
     {
-        if (placed_ships[k] == shipId)
-        {
-            ShipFound = true;
-            break;
-        }
+        m_ships[cell.shipId].hits--;
+        m_segmentsLeft++;
     }
-    if (!ShipFound)
-        return false; 
-    //check to see if board even contains coordinate 
-    if (topOrLeft.r < 0 || topOrLeft.c < 0 || topOrLeft.r >= m_game.rows() || topOrLeft.c >= m_game.cols())
+    cell.flags &= ~Cell::ATTACKED;
+    attacked_positions.pop_back();
+}
+
+void DynamicBoardImpl::replaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    ShipState& ship = m_ships[shipId];
+    int length = m_game.shipLength(shipId);
+    int step = (dir == HORIZONTAL ? 1 : m_cols);
+    ship.placed = true;
+    ship.topOrLeft = topOrLeft;
+    ship.dir = dir;
+    ship.hits = 0;
+    for (int k = 0, cell = cellIndex(topOrLeft); k < length; k++, cell += step)
+    {
+        m_cells[cell].shipId = shipId;
+        if (m_cells[cell].flags & Cell::HIT)
+            ship.hits++;
+    }
+    m_segmentsLeft += length - ship.hits;
+}
+
+void DynamicBoardImpl::save(BoardSnapshot& s) const
+{
+    int nWords = maskWords();
+    uint64_t* words = snapshotWords(s);
+    uint64_t* blocked = words;
+    uint64_t* attacked = words + nWords;
+    uint64_t* ships = words + 2 * nWords;
+    for (int k = 0; k < 2 * nWords; k++)
+        words[k] = 0;
+    for (size_t cell = 0; cell < m_cells.size(); cell++)
+    {
+        if (m_cells[cell].flags & Cell::BLOCKED)
+            blocked[cell >> 6] |= uint64_t(1) << (cell & 63);
+        if (m_cells[cell].flags & Cell::ATTACKED)
+            attacked[cell >> 6] |= uint64_t(1) << (cell & 63);
+    }
+    for (int id = 0; id < m_game.nShips(); id++)
+    {
+        if (id < static_cast<int>(m_ships.size()) && m_ships[id].placed)
+            packShip(ships, id, cellIndex(m_ships[id].topOrLeft), m_ships[id].dir == VERTICAL);
+        else
+            packShip(ships, id, -1, false);
+    }
+}
+
+bool DynamicBoardImpl::restore(const BoardSnapshot& s)
+{
+    int nWords = maskWords();
+    const uint64_t* words = snapshotWords(s);
+    if (words == nullptr)
         return false;
-    //check to see if point on the board has the given ship symbol 
-    if (game_board[topOrLeft.r][topOrLeft.c] == m_game.shipSymbol(shipId))
+    const uint64_t* blocked = words;
+    const uint64_t* attacked = words + nWords;
+    const uint64_t* ships = words + 2 * nWords;
+    clear();
+    if (static_cast<int>(m_ships.size()) < m_game.nShips())
+        m_ships.resize(m_game.nShips());
+    for (int id = 0; id < m_game.nShips(); id++)
     {
-        //check if point, dir is valid and if the next spot based on dir and point has the ship's symbol 
-        if (dir == HORIZONTAL && ((topOrLeft.c + m_game.shipLength(shipId)) <= m_game.cols()) && game_board[topOrLeft.r][topOrLeft.c + 1] == m_game.shipSymbol(shipId))
+        int start;
+        bool down;
+        if (!unpackShip(ships, id, start, down))
+            continue;
+        Point topOrLeft(start / m_cols, start % m_cols);
+        Direction dir = (down ? VERTICAL : HORIZONTAL);
+        int length = m_game.shipLength(id);
+        if (!fits(topOrLeft, length, dir))
         {
-            //remove ship and erase from vector 
-            for (int k = topOrLeft.c; k < (topOrLeft.c + m_game.shipLength(shipId)); k++)
-            {
-                game_board[topOrLeft.r][k] = '.'; 
-            }
-            placed_ships.erase(ship_location); 
-        }   
-        //check if point, dir is valid and if the next spot based on dir and point has the ship's symbol 
-        if (dir == VERTICAL && ((topOrLeft.r + m_game.shipLength(shipId)) <= m_game.rows()) && game_board[topOrLeft.r + 1][topOrLeft.c] == m_game.shipSymbol(shipId))
+            clear();
+            return false;
+        }
+        int step = (down ? m_cols : 1);
+        for (int k = 0, cell = start; k < length; k++, cell += step)
+            m_cells[cell].shipId = id;
+        m_ships[id].placed = true;
+        m_ships[id].topOrLeft = topOrLeft;
+        m_ships[id].dir = dir;
+        m_segmentsLeft += length;
+    }
+    //earlier shots are replayed in row-major order
+    for (size_t cell = 0; cell < m_cells.size(); cell++)
+    {
+        if ((blocked[cell >> 6] >> (cell & 63)) & 1)
+            m_cells[cell].flags |= Cell::BLOCKED;
+        if (!((attacked[cell >> 6] >> (cell & 63)) & 1))
+            continue;
+        attacked_positions.push_back(Point(cell / m_cols, cell % m_cols));
+        if (m_cells[cell].shipId < 0)
+            m_cells[cell].flags |= Cell::MISS;
+        else
         {
-            //remove ship and erase from vector 
-            for (int k = topOrLeft.r; k < (topOrLeft.r + m_game.shipLength(shipId)); k++)
-            {
-                game_board[k][topOrLeft.c] = '.';
-            }
-            placed_ships.erase(ship_location);
+            m_cells[cell].flags |= Cell::HIT;
+            m_ships[m_cells[cell].shipId].hits++;
+            m_segmentsLeft--;
         }
-        return false; 
     }
-    return false; 
+    return true;
 }
 
-void BoardImpl::display(bool shotsOnly) const
+//*********************************************************************
+//  FixedBoardImpl
+//*********************************************************************
+
+// A set of board cells, one bit per cell, numbered row-major.  Words is a
+// compile-time constant so every loop below has a fixed trip count and is
+// unrolled; a 10x10 board is two machine words.
+template<int Words>
+struct BitMask
 {
-    if (!(shotsOnly))
+    uint64_t w[Words];
+
+    BitMask() { reset(); }
+    void reset()
+    {
+        for (int k = 0; k < Words; k++)
+            w[k] = 0;
+    }
+    void set(int cell) { w[cell >> 6] |= uint64_t(1) << (cell & 63); }
+    // set exactly cells 0..n-1
+    void setFirst(int n)
     {
-        cout << "  ";
-        for (int t = 0; t < m_game.cols(); t++)
+        for (int k = 0; k < Words; k++)
         {
-            cout << t;
+            int bits = n - 64 * k;
+            w[k] = (bits >= 64 ? ~uint64_t(0) : bits > 0 ? (uint64_t(1) << bits) - 1 : 0);
         }
-        cout << endl;
-        for (int m = 0; m < m_game.rows(); m++)
+    }
+    void reset(int cell) { w[cell >> 6] &= ~(uint64_t(1) << (cell & 63)); }
+    bool test(int cell) const { return (w[cell >> 6] >> (cell & 63)) & 1; }
+    // lowest cell in the set, or -1 if it is empty
+    int first() const
+    {
+        for (int k = 0; k < Words; k++)
         {
-            cout << m << " ";
-            for (int k = 0; k < m_game.cols(); k++)
-            {
-                cout << game_board[m][k];
-            }
-            cout << endl;
+            if (w[k] != 0)
+                return 64 * k + __builtin_ctzll(w[k]);
         }
+        return -1;
+    }
+    bool any() const
+    {
+        uint64_t acc = 0;
+        for (int k = 0; k < Words; k++)
+            acc |= w[k];
+        return acc != 0;
+    }
+    bool intersects(const BitMask& other) const
+    {
+        uint64_t acc = 0;
+        for (int k = 0; k < Words; k++)
+            acc |= w[k] & other.w[k];
+        return acc != 0;
+    }
+    // true if every cell of this set is also in other
+    bool subsetOf(const BitMask& other) const
+    {
+        uint64_t acc = 0;
+        for (int k = 0; k < Words; k++)
+            acc |= w[k] & ~other.w[k];
+        return acc == 0;
+    }
+    bool operator==(const BitMask& other) const
+    {
+        uint64_t acc = 0;
+        for (int k = 0; k < Words; k++)
+            acc |= w[k] ^ other.w[k];
+        return acc == 0;
+    }
+    BitMask& operator|=(const BitMask& other)
+    {
+        for (int k = 0; k < Words; k++)
+            w[k] |= other.w[k];
+        return *this;
     }
+    BitMask& operator&=(const BitMask& other)
+    {
+        for (int k = 0; k < Words; k++)
+            w[k] &= other.w[k];
+        return *this;
+    }
+    BitMask& clearBits(const BitMask& other)
+    {
+        for (int k = 0; k < Words; k++)
+            w[k] &= ~other.w[k];
+        return *this;
+    }
+};
+
+template<int Rows, int Cols>
+class FixedBoardImpl : public BoardImpl
+{
+public:
+    FixedBoardImpl(const Game& g);
+    virtual void clear();
+    virtual void block(double fraction);
+    virtual void unblock();
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    virtual int attackBatch(const Point* shots, int n, ShotResult* results);
+    virtual bool allShipsDestroyed() const;
+    virtual int shipsAfloat() const;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    virtual bool isFree(Point p) const;
+    virtual void save(BoardSnapshot& s) const;
+    virtual bool restore(const BoardSnapshot& s);
+
+private:
+    static const int CELLS = Rows * Cols;
+    typedef BitMask<(CELLS + 63) / 64> Mask;
+
+    Mask m_blocked;             // cells marked '#' by block()
+    Mask m_occupied;            // union of all ship masks
+    Mask m_hits;                // attacked cells that held a ship segment
+    Mask m_attacked;            // every attacked cell, hit or miss
+    vector<Mask> m_ships;       // occupancy mask per shipId (empty if unplaced)
+    vector<Point> attacked_positions;   // shot history in order, for replay
+
+    static int cellIndex(Point p) { return p.r * Cols + p.c; }
+    bool shipMask(Point topOrLeft, int shipId, Direction dir, Mask& mask) const;
+    char cellSymbol(int cell, bool shotsOnly) const;
+    virtual void rowSymbols(int row, bool shotsOnly, char* symbols) const;
+    virtual void unattack(Point p);
+    virtual void replaceShip(Point topOrLeft, int shipId, Direction dir);
+};
+
+template<int Rows, int Cols>
+FixedBoardImpl<Rows, Cols>::FixedBoardImpl(const Game& g)
+    : BoardImpl(g), m_ships(g.nShips())
+{
+    attacked_positions.reserve(CELLS);
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::clear()
+{
+    m_blocked.reset();
+    m_occupied.reset();
+    m_hits.reset();
+    m_attacked.reset();
+    for (size_t k = 0; k < m_ships.size(); k++)
+        m_ships[k].reset();
+    attacked_positions.clear();
+    discardUndo();
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::block(double fraction)
+{
+    int nBlocked = blockCount(fraction);
+    //pick whichever of the blocked and the open cells are fewer
+    bool pickBlocked = (nBlocked <= CELLS - nBlocked);
+    int nPicked = (pickBlocked ? nBlocked : CELLS - nBlocked);
+    pickCells(nPicked);
+    Mask picked;
+    for (int j = 0; j < nPicked; j++)
+        picked.set(m_order[j]);
+    if (pickBlocked)
+        m_blocked = picked;
     else
     {
-        cout << "  ";
-        for (int t = 0; t < m_game.cols(); t++)
-        {
-            cout << t;
-        }
-        cout << endl;
-        for (int m = 0; m < m_game.rows(); m++)
+        m_blocked.setFirst(CELLS);
+        m_blocked.clearBits(picked);
+    }
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::unblock()
+{
+    m_blocked.reset();
+}
+
+// Compute the cells a ship would cover; false if it would leave the board
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::shipMask(Point topOrLeft, int shipId, Direction dir, Mask& mask) const
+{
+    if (topOrLeft.r < 0 || topOrLeft.c < 0 || topOrLeft.r >= Rows || topOrLeft.c >= Cols)
+        return false;
+    int length = m_game.shipLength(shipId);
+    if (dir == HORIZONTAL ? topOrLeft.c + length > Cols : topOrLeft.r + length > Rows)
+        return false;
+    int step = (dir == HORIZONTAL ? 1 : Cols);
+    mask.reset();
+    for (int k = 0, cell = cellIndex(topOrLeft); k < length; k++, cell += step)
+        mask.set(cell);
+    return true;
+}
+
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+    //validate shipId
+    if (shipId < 0 || shipId >= m_game.nShips())
+        return false;
+    if (shipId >= static_cast<int>(m_ships.size()))
+        m_ships.resize(m_game.nShips());
+    //make sure ship has not previously been placed already on the board 
+    if (m_ships[shipId].any())
+        return false;
+    //make sure point is valid and ship is not placed outside board 
+    Mask mask;
+    if (!shipMask(topOrLeft, shipId, dir, mask))
+        return false;
+    //make sure there is no overlap on anything (other ships, blocked positions, shots)
+    if (mask.intersects(m_occupied) || mask.intersects(m_blocked) || mask.intersects(m_attacked))
+        return false;
+    m_ships[shipId] = mask;
+    m_occupied |= mask;
+    logChange(Change::PLACE, topOrLeft, shipId, dir);
+    return true;
+}
+
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    //check if such a shipId has been placed on the board
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()) || !m_ships[shipId].any())
+        return false;
+    //the ship must lie exactly at the given point and direction
+    Mask mask;
+    if (!shipMask(topOrLeft, shipId, dir, mask) || !(mask == m_ships[shipId]))
+        return false;
+    m_occupied.clearBits(mask);
+    m_ships[shipId].reset();
+    logChange(Change::UNPLACE, topOrLeft, shipId, dir);
+    return true;
+}
+
+template<int Rows, int Cols>
+char FixedBoardImpl<Rows, Cols>::cellSymbol(int cell, bool shotsOnly) const
+{
+    if (m_attacked.test(cell))
+        return m_hits.test(cell) ? 'X' : 'o';
+    if (shotsOnly)
+        return '.';
+    if (m_occupied.test(cell))
+    {
+        for (size_t s = 0; s < m_ships.size(); s++)
         {
-            cout << m << " ";
-            for (int k = 0; k < m_game.cols(); k++)
-            {
-                if ((game_board[m][k] == '.') || (game_board[m][k] == 'X') || (game_board[m][k] == 'o'))
-                {
-                    cout << game_board[m][k];
-                }
-                else
-                    cout << '.'; 
-            }
-            cout << endl;
+            if (m_ships[s].test(cell))
+                return m_game.shipSymbol(s);
         }
     }
+    if (m_blocked.test(cell))
+        return '#';
+    return '.';
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::rowSymbols(int row, bool shotsOnly, char* symbols) const
+{
+    for (int k = 0; k < Cols; k++)
+        symbols[k] = cellSymbol(row * Cols + k, shotsOnly);
 }
 
-bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
-    vector<Point> ::iterator attack_pointer = attacked_positions.begin(); 
     //check to see if board even contains coordinate 
-    if (p.r < 0 || p.c < 0 || p.r >= m_game.rows() || p.c >= m_game.cols())
+    if (p.r < 0 || p.c < 0 || p.r >= Rows || p.c >= Cols)
+        return false;
+    int cell = cellIndex(p);
+    //location has been hit previously so return false 
+    if (m_attacked.test(cell))
         return false;
-    //if this is first attack for a board, proceed with the attack 
-    if (attacked_positions.size() == 0)
+    m_attacked.set(cell);
+    attacked_positions.push_back(p);
+    logChange(Change::ATTACK, p, -1, HORIZONTAL);
+    shipDestroyed = false;
+    shotHit = m_occupied.test(cell);
+    //missed attack 
+    if (!shotHit)
+        return true;
+    //boat has been hit; it is destroyed once all its cells are hits
+    m_hits.set(cell);
+    for (size_t s = 0; s < m_ships.size(); s++)
     {
-        //missed attack 
-        if (game_board[p.r][p.c] == '.')
+        if (m_ships[s].test(cell))
         {
-            game_board[p.r][p.c] = 'o';
-            attacked_positions.push_back(p);
-            shipDestroyed = false; 
-            shotHit = false; 
-            return true; 
-        }
-        else
-        { //boat has been hit 
-            //has this ship been entirely destroyed? 
-            char boat_symbol = game_board[p.r][p.c]; 
-            int symbols_left = 0; 
-            for (int t = 0; t < m_game.rows(); t++)
+            if (m_ships[s].subsetOf(m_hits))
             {
-                for (int g = 0; g < m_game.cols(); g++)
-                {
-                    if (game_board[t][g] == boat_symbol)
-                    {
-                        symbols_left++;
-                    }
-                }
-            }
-            //ship has been entirely destroyed 
-            if (symbols_left == 1)
-            {
-                for (int h = 0; h < placed_ships.size(); h++)
-                {
-                    if (m_game.shipSymbol(placed_ships[h]) == boat_symbol)
-                    {
-                        shipId = placed_ships[h];
-                        shipDestroyed = true; 
-                        break; 
-                    }
-                }
+                shipId = s;
+                shipDestroyed = true;
             }
-            else
-            {
-                shipDestroyed = false;
-            }
-            game_board[p.r][p.c] = 'X';
-            attacked_positions.push_back(p); 
-            shotHit = true; 
-            return true; 
+            break;
         }
     }
-    for (int k = 0; k < attacked_positions.size(); k++, attack_pointer++)
-    {
-        //location has been hit previously so return false 
-        if (((*attack_pointer).r == p.r) && ((*attack_pointer).c == p.c))
-         {
-            return false; 
-         }
-    }
-    //missed attack 
-    if (game_board[p.r][p.c] == '.')
+    return true;
+}
+
+// Every shot is checked and marked in one pass, and the hits are then
+// added to m_hits at once; only ships the batch hit are looked at again
+template<int Rows, int Cols>
+int FixedBoardImpl<Rows, Cols>::attackBatch(const Point* shots, int n, ShotResult* results)
+{
+    Mask fired;
+    int nValid = 0;
+    for (int k = 0; k < n; k++)
     {
-        game_board[p.r][p.c] = 'o';
+        Point p = shots[k];
+        ShotResult& r = results[k];
+        r.destroyed = false;
+        r.shipId = -1;
+        int cell = cellIndex(p);
+        r.valid = p.r >= 0 && p.c >= 0 && p.r < Rows && p.c < Cols && !m_attacked.test(cell);
+        r.hit = r.valid && m_occupied.test(cell);
+        if (!r.valid)
+            continue;
+        m_attacked.set(cell);
+        fired.set(cell);
         attacked_positions.push_back(p);
-        shipDestroyed = false;
-        shotHit = false;
-        return true;
+        logChange(Change::ATTACK, p, -1, HORIZONTAL);
+        nValid++;
     }
-    else
-    { //boat has been hit 
-        //has this ship been entirely destroyed? 
-        char boat_symbol = game_board[p.r][p.c];
-        int symbols_left = 0;
-        for (int t = 0; t < m_game.rows(); t++)
-        {
-            for (int g = 0; g < m_game.cols(); g++)
-            {
-                if (game_board[t][g] == boat_symbol)
-                {
-                    symbols_left++;
-                }
-            }
-        }
-        //ship has been entirely destroyed 
-        if (symbols_left == 1)
+    fired &= m_occupied;
+    if (!fired.any())
+        return nValid;
+    m_hits |= fired;
+    //a ship the batch sank goes down with the last shot that hit it
+    Mask credited;
+    for (int k = n - 1; k >= 0; k--)
+    {
+        int cell = cellIndex(shots[k]);
+        if (!results[k].hit || credited.test(cell))
+            continue;
+        for (size_t s = 0; s < m_ships.size(); s++)
         {
-            for (int h = 0; h < placed_ships.size(); h++)
+            if (m_ships[s].test(cell))
             {
-                if (m_game.shipSymbol(placed_ships[h]) == boat_symbol)
+                credited |= m_ships[s];
+                if (m_ships[s].subsetOf(m_hits))
                 {
-                    shipId = placed_ships[h];
-                    shipDestroyed = true;
-                    break;
+                    results[k].destroyed = true;
+                    results[k].shipId = s;
                 }
+                break;
             }
         }
+    }
+    return nValid;
+}
+
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::allShipsDestroyed() const
+{
+    return m_occupied.subsetOf(m_hits);
+}
+
+template<int Rows, int Cols>
+int FixedBoardImpl<Rows, Cols>::shipsAfloat() const
+{
+    int afloat = 0;
+    for (size_t s = 0; s < m_ships.size(); s++)
+    {
+        if (m_ships[s].any() && !m_ships[s].subsetOf(m_hits))
+            afloat++;
+    }
+    return afloat;
+}
+
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()) || !m_ships[shipId].any())
+        return false;
+    //the ship's first cell in row-major order is its top or left end
+    int first = m_ships[shipId].first();
+    topOrLeft = Point(first / Cols, first % Cols);
+    bool horizontal = m_game.shipLength(shipId) > 1 && first % Cols + 1 < Cols &&
+        m_ships[shipId].test(first + 1);
+    dir = (horizontal ? HORIZONTAL : VERTICAL);
+    return true;
+}
+
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::isFree(Point p) const
+{
+    if (p.r < 0 || p.c < 0 || p.r >= Rows || p.c >= Cols)
+        return false;
+    return !m_blocked.test(cellIndex(p)) && !m_occupied.test(cellIndex(p));
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::unattack(Point p)
+{
+    m_attacked.reset(cellIndex(p));
+    m_hits.reset(cellIndex(p));
+    attacked_positions.pop_back();
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::replaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    Mask mask;
+    shipMask(topOrLeft, shipId, dir, mask);
+    m_ships[shipId] = mask;
+    m_occupied |= mask;
+}
+
+template<int Rows, int Cols>
+void FixedBoardImpl<Rows, Cols>::save(BoardSnapshot& s) const
+{
+    const int nWords = sizeof(Mask) / sizeof(uint64_t);
+    uint64_t* words = snapshotWords(s);
+    for (int k = 0; k < nWords; k++)
+    {
+        words[k] = m_blocked.w[k];
+        words[nWords + k] = m_attacked.w[k];
+    }
+    uint64_t* ships = words + 2 * nWords;
+    for (int id = 0; id < m_game.nShips(); id++)
+    {
+        Point topOrLeft;
+        Direction dir;
+        if (shipPlacement(id, topOrLeft, dir))
+            packShip(ships, id, cellIndex(topOrLeft), dir == VERTICAL);
         else
-        {
-            shipDestroyed = false;
-        }
-        game_board[p.r][p.c] = 'X';
-        attacked_positions.push_back(p);
-        shotHit = true;
-        return true;
+            packShip(ships, id, -1, false);
     }
 }
 
-bool BoardImpl::allShipsDestroyed() const
+template<int Rows, int Cols>
+bool FixedBoardImpl<Rows, Cols>::restore(const BoardSnapshot& s)
 {
-    bool ship_left = false;
-    for (int t = 0; t < m_game.rows(); t++)
+    const int nWords = sizeof(Mask) / sizeof(uint64_t);
+    const uint64_t* words = snapshotWords(s);
+    if (words == nullptr)
+        return false;
+    clear();
+    if (static_cast<int>(m_ships.size()) < m_game.nShips())
+        m_ships.resize(m_game.nShips());
+    for (int k = 0; k < nWords; k++)
+    {
+        m_blocked.w[k] = words[k];
+        m_attacked.w[k] = words[nWords + k];
+    }
+    const uint64_t* ships = words + 2 * nWords;
+    for (int id = 0; id < m_game.nShips(); id++)
     {
-        for (int g = 0; g < m_game.cols(); g++)
+        int start;
+        bool down;
+        if (!unpackShip(ships, id, start, down))
+            continue;
+        Mask mask;
+        if (!shipMask(Point(start / Cols, start % Cols), id, down ? VERTICAL : HORIZONTAL, mask))
         {
-            if ((game_board[t][g] != '.') && (game_board[t][g] != 'o') && (game_board[t][g] != 'X'))
-            {
-                ship_left = true; 
-                break; 
-            }
+            clear();
+            return false;
         }
+        m_ships[id] = mask;
+        m_occupied |= mask;
     }
-    return (!ship_left); 
+    m_hits = m_attacked;
+    m_hits &= m_occupied;
+    //earlier shots are replayed in row-major order
+    for (int k = 0; k < nWords; k++)
+    {
+        for (uint64_t bits = m_attacked.w[k]; bits != 0; bits &= bits - 1)
+        {
+            int cell = 64 * k + __builtin_ctzll(bits);
+            attacked_positions.push_back(Point(cell / Cols, cell % Cols));
+        }
+    }
+    return true;
 }
 
 //******************** Board functions ********************************
@@ -390,7 +1175,15 @@ bool BoardImpl::allShipsDestroyed() const
 
 Board::Board(const Game& g)
 {
-    m_impl = new BoardImpl(g);
+    // Pick a compile-time-sized engine for the common board sizes
+    if (g.rows() == 10 && g.cols() == 10)
+        m_impl = new FixedBoardImpl<10, 10>(g);
+    else if (g.rows() == 8 && g.cols() == 8)
+        m_impl = new FixedBoardImpl<8, 8>(g);
+    else if (g.rows() == 2 && g.cols() == 3)
+        m_impl = new FixedBoardImpl<2, 3>(g);
+    else
+        m_impl = new DynamicBoardImpl(g);
 }
 
 Board::~Board()
@@ -403,9 +1196,14 @@ void Board::clear()
     m_impl->clear();
 }
 
-void Board::block()
+void Board::reset()
+{
+    m_impl->reset();
+}
+
+void Board::block(double fraction)
 {
-    return m_impl->block();
+    return m_impl->block(fraction);
 }
 
 void Board::unblock()
@@ -425,7 +1223,22 @@ bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 
 void Board::display(bool shotsOnly) const
 {
-    m_impl->display(shotsOnly);
+    m_impl->display(shotsOnly, cout);
+}
+
+void Board::display(bool shotsOnly, ostream& out) const
+{
+    m_impl->display(shotsOnly, out);
+}
+
+void Board::redisplay(bool shotsOnly, ostream& out) const
+{
+    m_impl->redisplay(shotsOnly, out);
+}
+
+void Board::prepareDisplay() const
+{
+    m_impl->prepareDisplay();
 }
 
 bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
@@ -433,7 +1246,47 @@ bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+int Board::attackBatch(const Point* shots, int n, ShotResult* results)
+{
+    return m_impl->attackBatch(shots, n, results);
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+int Board::shipsAfloat() const
+{
+    return m_impl->shipsAfloat();
+}
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+bool Board::isFree(Point p) const
+{
+    return m_impl->isFree(p);
+}
+
+void Board::save(BoardSnapshot& s) const
+{
+    m_impl->save(s);
+}
+
+bool Board::restore(const BoardSnapshot& s)
+{
+    return m_impl->restore(s);
+}
+
+void Board::pushUndo()
+{
+    m_impl->pushUndo();
+}
+
+bool Board::popUndo()
+{
+    return m_impl->popUndo();
+}
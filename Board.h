@@ -2,23 +2,94 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <iosfwd>
+#include <vector>
+#include <cstdint>
 
 class Game;
 class BoardImpl;
 
+// The state of a board -- its blocked cells, where each ship sits and
+// which cells were attacked -- as a plain value that Board::save fills in
+// and Board::restore reads back.  A 10x10 board with a handful of ships
+// fits in the object itself, so copying one costs a few machine words;
+// bigger boards keep the state on the heap.
+class BoardSnapshot
+{
+public:
+    BoardSnapshot() : m_inline(), m_fleet(0), m_rows(0), m_cols(0), m_size(0) {}
+
+private:
+    friend class BoardImpl;
+    enum { INLINE_WORDS = 8 };
+
+    std::uint64_t m_inline[INLINE_WORDS];
+    std::vector<std::uint64_t> m_spill;     // used instead when m_size is bigger
+    std::uint64_t m_fleet;                  // hash of the ship lengths saved
+    int m_rows;                             // of the board saved
+    int m_cols;
+    int m_size;                             // words in use
+};
+
+// The outcome of one shot of Board::attackBatch, as attack reports it
+struct ShotResult
+{
+    bool valid;
+    bool hit;
+    bool destroyed;
+    int shipId;         // the ship sunk if destroyed, otherwise -1
+};
+
 class Board
 {
 public:
     Board(const Game& g);
     ~Board();
     void clear();
-    void block();
+    // Clear the board and forget everything else it has kept, so that it
+    // behaves exactly like a newly constructed one, without reallocating
+    void reset();
+    // Mark a random fraction of the cells (rounded down) as blocked, and
+    // the rest as not; exactly that many, every such set equally likely
+    void block(double fraction = 0.5);
     void unblock();
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    // Draw the board with one write to the stream
     void display(bool shotsOnly) const;
+    void display(bool shotsOnly, std::ostream& out) const;
+    // For a terminal: when this board's last display went to out with the
+    // same shotsOnly, and nothing has been written to out since, rewrite in
+    // place just the cells that changed, using ANSI cursor movement, and
+    // leave the cursor below the board again.  Otherwise the same as display.
+    void redisplay(bool shotsOnly, std::ostream& out) const;
+    // Set up the frame display draws into, which is otherwise done by the
+    // first display, so that no display allocates memory
+    void prepareDisplay() const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    // Fire n shots at once, for salvo games: each result is what n calls of
+    // attack in order would have reported, so a shot at a cell fired on
+    // earlier in the batch is invalid and a ship is destroyed by the last
+    // shot of the batch that hit it.  Returns the number of valid shots.
+    int attackBatch(const Point* shots, int n, ShotResult* results);
     bool allShipsDestroyed() const;
+    // Placed ships with at least one cell not hit
+    int shipsAfloat() const;
+    // True if p is on the board, not blocked and not covered by a ship
+    bool isFree(Point p) const;
+    // Where a placed ship sits; false if shipId is not on the board
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    // Copy the board's state into s, or set it from s.  restore returns
+    // false for a snapshot of a board of another size or fleet.  Neither
+    // keeps the order of earlier shots, and restore (like clear) drops any
+    // open undo levels.
+    void save(BoardSnapshot& s) const;
+    bool restore(const BoardSnapshot& s);
+    // Open an undo level: popUndo takes back every successful attack,
+    // placeShip and unplaceShip since the matching pushUndo.  Levels nest;
+    // popUndo returns false if none is open.
+    void pushUndo();
+    bool popUndo();
     // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
@@ -0,0 +1,235 @@
+#include "DensityMap.h"
+#include "Game.h"
+#include "PlacementKernel.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+DensityMap::DensityMap(const Game& g)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+      m_state(g.rows() * g.cols(), UNKNOWN),
+      m_density(g.rows() * g.cols(), 0)
+{
+    //group the fleet by ship length
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        size_t i = 0;
+        while (i < m_lengths.size() && m_lengths[i] != g.shipLength(s))
+            i++;
+        if (i == m_lengths.size())
+        {
+            m_lengths.push_back(g.shipLength(s));
+            m_fleet.push_back(0);
+        }
+        m_fleet[i]++;
+    }
+    //on an empty board every in-bounds placement is legal with weight 1
+    PlacementKernel kernel(m_rows, m_cols);
+    vector<unsigned char> none(m_state.size(), 0);
+    kernel.setBoard(&none[0], &none[0]);
+    vector<int> counts(m_state.size());
+    m_emptyCover.resize(m_lengths.size());
+    for (size_t i = 0; i < m_lengths.size(); i++)
+    {
+        fill(counts.begin(), counts.end(), 0);
+        kernel.accumulate(m_lengths[i], HIT_BONUS, 1, &counts[0]);
+        m_emptyCover[i].assign(counts.begin(), counts.end());
+    }
+    m_leaves = 1;
+    while (m_leaves < static_cast<int>(m_state.size()))
+        m_leaves *= 2;
+    reset();
+}
+
+void DensityMap::reset()
+{
+    //copying into the vectors already sized for this board allocates nothing
+    fill(m_state.begin(), m_state.end(), static_cast<unsigned char>(UNKNOWN));
+    m_afloat = m_fleet;
+    m_cover = m_emptyCover;
+    fill(m_density.begin(), m_density.end(), 0);
+    for (size_t i = 0; i < m_lengths.size(); i++)
+    {
+        for (size_t cell = 0; cell < m_state.size(); cell++)
+            m_density[cell] += m_afloat[i] * m_cover[i][cell];
+    }
+    rebuildTree();
+}
+
+Point DensityMap::best() const
+{
+    if (m_tree[1] < 0)
+        return Point(0, 0);
+    //walk down towards the child holding the maximum
+    int node = 1;
+    while (node < m_leaves)
+        node = (m_tree[2 * node] == m_tree[node] ? 2 * node : 2 * node + 1);
+    int cell = node - m_leaves;
+    return Point(cell / m_cols, cell % m_cols);
+}
+
+void DensityMap::best(Point* cells, int k) const
+{
+    //insertion into the k best so far; k is a salvo, so small
+    int found = 0;
+    for (int cell = 0; cell < static_cast<int>(m_state.size()) && k > 0; cell++)
+    {
+        long long d = m_tree[m_leaves + cell];
+        if (d < 0 || (found == k && d <= m_density[index(cells[k - 1])]))
+            continue;
+        int j = (found < k ? found++ : k - 1);
+        for (; j > 0 && m_density[index(cells[j - 1])] < d; j--)
+            cells[j] = cells[j - 1];
+        cells[j] = Point(cell / m_cols, cell % m_cols);
+    }
+    for (int j = found; j < k; j++)
+        cells[j] = Point(0, 0);
+}
+
+void DensityMap::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!m_game.isValid(p) || m_state[index(p)] != UNKNOWN)
+        return;
+    setState(index(p), shotHit ? HIT : MISS);
+    if (!shotHit || !shipDestroyed)
+        return;
+    //one fewer ship of that length is left to place
+    int length = m_game.shipLength(shipId);
+    size_t i = 0;
+    while (i < m_lengths.size() && m_lengths[i] != length)
+        i++;
+    if (i == m_lengths.size() || m_afloat[i] == 0)
+        return;
+    m_afloat[i]--;
+    for (size_t cell = 0; cell < m_state.size(); cell++)
+        m_density[cell] -= m_cover[i][cell];
+    rebuildTree();
+    markSunk(p, length);
+}
+
+long long DensityMap::weight(int start, int len, int step) const
+{
+    long long w = 1;
+    for (int k = 0, cell = start; k < len; k++, cell += step)
+    {
+        if (m_state[cell] == MISS || m_state[cell] == SUNK)
+            return -1;
+        if (m_state[cell] == HIT)
+            w += HIT_BONUS;
+    }
+    return w;
+}
+
+void DensityMap::setState(int cell, CellState newState)
+{
+    int r = cell / m_cols;
+    int c = cell % m_cols;
+    for (size_t i = 0; i < m_lengths.size(); i++)
+    {
+        if (m_afloat[i] == 0)
+            continue;
+        int len = m_lengths[i];
+        for (int o = 0; o < len; o++)
+        {
+            //placement across starting o cells to the left, then down
+            //starting o cells above
+            for (int d = 0; d < 2; d++)
+            {
+                int step;
+                int start;
+                if (d == 0)
+                {
+                    if (c - o < 0 || c - o + len > m_cols)
+                        continue;
+                    step = 1;
+                    start = cell - o;
+                }
+                else
+                {
+                    if (r - o < 0 || r - o + len > m_rows)
+                        continue;
+                    step = m_cols;
+                    start = cell - o * m_cols;
+                }
+                long long w = weight(start, len, step);
+                if (w < 0)
+                    continue;
+                //a new hit makes the placement likelier; a miss or a sunk
+                //ship rules it out
+                long long delta = (newState == HIT ? static_cast<long long>(HIT_BONUS) : -w);
+                for (int k = 0, t = start; k < len; k++, t += step)
+                {
+                    m_cover[i][t] += delta;
+                    m_density[t] += m_afloat[i] * delta;
+                    update(t);
+                }
+            }
+        }
+    }
+    m_state[cell] = newState;
+    update(cell);
+}
+
+void DensityMap::update(int cell)
+{
+    int node = m_leaves + cell;
+    m_tree[node] = (m_state[cell] == UNKNOWN ? m_density[cell] : -1);
+    for (node /= 2; node >= 1; node /= 2)
+    {
+        long long top = max(m_tree[2 * node], m_tree[2 * node + 1]);
+        if (m_tree[node] == top)
+            break;
+        m_tree[node] = top;
+    }
+}
+
+void DensityMap::rebuildTree()
+{
+    m_tree.assign(2 * m_leaves, -1);
+    for (size_t cell = 0; cell < m_state.size(); cell++)
+    {
+        if (m_state[cell] == UNKNOWN)
+            m_tree[m_leaves + cell] = m_density[cell];
+    }
+    for (int node = m_leaves - 1; node >= 1; node--)
+        m_tree[node] = max(m_tree[2 * node], m_tree[2 * node + 1]);
+}
+
+// The ship of the given length just sunk at p.  If exactly one run of hits
+// of that length passes through p, those cells are its wreck and can no
+// longer be part of any other ship.
+void DensityMap::markSunk(Point p, int length)
+{
+    int found = 0;
+    int wreckStart = 0;
+    int wreckStep = 1;
+    for (int d = 0; d < 2; d++)
+    {
+        int step = (d == 0 ? 1 : m_cols);
+        for (int o = 0; o < length; o++)
+        {
+            int r = p.r - (d == 1 ? o : 0);
+            int c = p.c - (d == 0 ? o : 0);
+            if (r < 0 || c < 0 || (d == 0 ? c + length > m_cols : r + length > m_rows))
+                continue;
+            int start = r * m_cols + c;
+            int k = 0;
+            while (k < length && m_state[start + k * step] == HIT)
+                k++;
+            if (k == length)
+            {
+                found++;
+                wreckStart = start;
+                wreckStep = step;
+            }
+        }
+        //a length-1 ship is found once in each direction
+        if (length == 1)
+            break;
+    }
+    if (found != 1)
+        return;
+    for (int k = 0; k < length; k++)
+        setState(wreckStart + k * wreckStep, SUNK);
+}
@@ -0,0 +1,66 @@
+#ifndef DENSITYMAP_INCLUDED
+#define DENSITYMAP_INCLUDED
+
+#include "globals.h"
+#include <vector>
+
+class Game;
+
+// For every cell of the opponent's board, a weighted count of the ways the
+// ships not yet sunk could be placed to cover it, given the shots so far.
+// A placement may not cover a miss or a cell of a sunk ship; placements
+// that cover unsunk hits are weighted up so that hits get followed up.
+//
+// The map is updated incrementally as results come in: a shot only
+// touches the O(L^2) placements of each length L that pass through the
+// cell, and the best cell to attack is kept in a max segment tree, so a
+// query is O(1) and an update O(log(rows*cols)).
+class DensityMap
+{
+public:
+    DensityMap(const Game& g);
+    // The untried cell with the highest density; (0, 0) if none is left
+    Point best() const;
+    // The k untried cells with the highest density, best first and the
+    // lowest of equals first, so that cells[0] is best(); cells past the
+    // untried ones are (0, 0)
+    void best(Point* cells, int k) const;
+    long long density(Point p) const { return m_density[index(p)]; }
+    // Record the result of attacking p, as passed to recordAttackResult
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+    // Forget every result, as if newly constructed
+    void reset();
+
+private:
+    enum CellState { UNKNOWN, MISS, HIT, SUNK };
+    // Extra weight for each unsunk hit a placement covers
+    enum { HIT_BONUS = 64 };
+
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    std::vector<unsigned char> m_state;     // CellState per cell, row-major
+    std::vector<int> m_lengths;             // distinct ship lengths
+    std::vector<int> m_fleet;               // ships of each length
+    std::vector<int> m_afloat;              // unsunk ships of each length
+    // m_cover[i][cell]: total weight of the legal placements of a ship of
+    // length m_lengths[i] that cover cell
+    std::vector<std::vector<long long> > m_cover;
+    std::vector<std::vector<long long> > m_emptyCover;     // m_cover before any shot
+    std::vector<long long> m_density;       // sum over i of m_afloat[i] * m_cover[i]
+    std::vector<long long> m_tree;          // max of m_density over untried cells
+    int m_leaves;
+
+    int index(Point p) const { return p.r * m_cols + p.c; }
+    // Weight of the placement of length len starting at cell start with the
+    // given step (1 across, m_cols down), or -1 if it is not legal
+    long long weight(int start, int len, int step) const;
+    // Move cell to newState, updating every placement that passes through it
+    void setState(int cell, CellState newState);
+    // Refresh cell's leaf of the segment tree and its ancestors
+    void update(int cell);
+    void rebuildTree();
+    void markSunk(Point p, int length);
+};
+
+#endif // DENSITYMAP_INCLUDED
@@ -0,0 +1,540 @@
+#include "EndgameSolver.h"
+#include "Game.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Positions kept before the table is emptied, and its first size in
+    // slots
+    const size_t TABLE_LIMIT = 1 << 21;
+    const size_t FIRST_SLOTS = 1 << 10;
+    // Values closer than this count as equal
+    const double EPSILON = 1e-9;
+    // Unknown cells per layout allowed beyond which listing is not tried:
+    // a ship afloat clear of the hits could lie almost anywhere among them
+    const int UNKNOWN_PER_LAYOUT = 8;
+}
+
+EndgameSolver::EndgameSolver(const Game& g, int maxLayouts, long long maxWork)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()), m_cells(g.rows() * g.cols()),
+      m_maxLayouts(maxLayouts), m_maxWork(maxWork),
+      m_hit(m_cells, 0), m_miss(m_cells, 0), m_unknown(m_cells), m_listed(false), m_listWait(0), m_listBackoff(1),
+      m_stamp(1), m_stored(0), m_depth(0), m_work(0), m_aborted(false), m_retryAt(maxLayouts)
+{
+    for (int s = 0; s < g.nShips(); s++)
+        m_lengths.push_back(g.shipLength(s));
+    // fixed seed: the hashes only need to differ, not to vary between games
+    Rng rng(0x5EED5EED5EED5EEDULL);
+    for (int cell = 0; cell < m_cells; cell++)
+        m_zHit.push_back(Key(rng.next(), rng.next()));
+}
+
+void EndgameSolver::reset()
+{
+    m_shots.clear();
+    m_unknown = m_cells;
+    fill(m_hit.begin(), m_hit.end(), 0);
+    fill(m_miss.begin(), m_miss.end(), 0);
+    m_listed = false;
+    m_listWait = 0;
+    m_listBackoff = 1;
+    m_layouts.clear();
+    m_alive.clear();
+    clearTable();
+    m_retryAt = m_maxLayouts;
+}
+
+void EndgameSolver::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!m_game.isValid(p))
+        return;
+    int cell = p.r * m_cols + p.c;
+    if (m_hit[cell] || m_miss[cell])
+        return;
+    Shot shot = { cell, shotHit, shotHit && shipDestroyed, shipId };
+    if (m_listed)
+    {
+        size_t kept = 0;
+        for (size_t k = 0; k < m_alive.size(); k++)
+        {
+            if (agrees(m_alive[k], shot, m_hit))
+                m_alive[kept++] = m_alive[k];
+        }
+        m_alive.resize(kept);
+    }
+    m_shots.push_back(shot);
+    m_unknown--;
+    if (m_listWait > 0)
+        m_listWait--;
+    if (shotHit)
+        m_hit[cell] = 1;
+    else
+        m_miss[cell] = 1;
+}
+
+int EndgameSolver::shipAt(int layout, int cell) const
+{
+    int nShips = m_lengths.size();
+    const Placement* ships = &m_layouts[layout * nShips];
+    for (int s = 0; s < nShips; s++)
+    {
+        int offset = cell - ships[s].start;
+        if (offset < 0)
+            continue;
+        if (ships[s].step == 1 ? offset < m_lengths[s] && cell / m_cols == ships[s].start / m_cols
+                               : offset % m_cols == 0 && offset / m_cols < m_lengths[s])
+            return s;
+    }
+    return -1;
+}
+
+bool EndgameSolver::sinks(int layout, int cell, const vector<char>& hit) const
+{
+    int s = shipAt(layout, cell);
+    Placement p = m_layouts[layout * m_lengths.size() + s];
+    for (int k = 0, c = p.start; k < m_lengths[s]; k++, c += p.step)
+    {
+        if (c != cell && !hit[c])
+            return false;
+    }
+    return true;
+}
+
+int EndgameSolver::unhitCells(int layout, const vector<char>& hit) const
+{
+    int nShips = m_lengths.size();
+    int unhit = 0;
+    for (int s = 0; s < nShips; s++)
+    {
+        Placement p = m_layouts[layout * nShips + s];
+        for (int k = 0, c = p.start; k < m_lengths[s]; k++, c += p.step)
+            unhit += !hit[c];
+    }
+    return unhit;
+}
+
+bool EndgameSolver::agrees(int layout, const Shot& shot, const vector<char>& hitBefore) const
+{
+    int s = shipAt(layout, shot.cell);
+    if ((s >= 0) != shot.hit)
+        return false;
+    if (s < 0)
+        return true;
+    bool sunk = sinks(layout, shot.cell, hitBefore);
+    if (sunk != shot.destroyed)
+        return false;
+    return !sunk || s == shot.shipId;
+}
+
+//*********************************************************************
+//  Listing the layouts
+//*********************************************************************
+
+bool EndgameSolver::listLayouts()
+{
+    int nShips = m_lengths.size();
+    m_layouts.clear();
+    m_alive.clear();
+    m_sunkAt.assign(nShips, -1);
+    for (size_t k = 0; k < m_shots.size(); k++)
+    {
+        if (m_shots[k].destroyed && m_shots[k].shipId >= 0 && m_shots[k].shipId < nShips)
+            m_sunkAt[m_shots[k].shipId] = m_shots[k].cell;
+    }
+    int hits = 0;
+    int lengthLeft = 0;
+    for (int cell = 0; cell < m_cells; cell++)
+        hits += m_hit[cell];
+    for (int s = 0; s < nShips; s++)
+        lengthLeft += m_lengths[s];
+    m_owner.assign(m_cells, -1);
+    m_current.assign(nShips, Placement());
+    m_work = 0;
+    if (!extend(hits, lengthLeft))
+    {
+        m_layouts.clear();
+        m_alive.clear();
+        return false;
+    }
+    m_listed = true;
+    clearTable();
+    Rng rng(0x7AB1E7AB1E7AB1E7ULL);
+    m_zLayout.clear();
+    for (size_t k = 0; k < m_alive.size(); k++)
+        m_zLayout.push_back(Key(rng.next(), rng.next()));
+    return true;
+}
+
+// Place the ships not placed yet every way that does not already
+// contradict a result; false once a limit is hit.  Sunk ships go first,
+// then the ships covering each uncovered hit in turn (the ship over a
+// given cell is unique, so no layout is listed twice), then the rest in
+// order.
+bool EndgameSolver::extend(int uncoveredHits, int lengthLeft)
+{
+    if (++m_work > m_maxWork)
+        return false;
+    if (uncoveredHits > lengthLeft)
+        return true;
+    int nShips = m_lengths.size();
+    auto place = [&](int s)
+    {
+        return [this, s, uncoveredHits, lengthLeft](Placement p)
+            { return tryPlacement(s, p, uncoveredHits, lengthLeft); };
+    };
+    for (int s = 0; s < nShips; s++)
+    {
+        if (m_sunkAt[s] < 0 || m_current[s].start >= 0)
+            continue;
+        return forEachPlacement(m_rows, m_cols, m_lengths[s], place(s));
+    }
+    if (uncoveredHits > 0)
+    {
+        int h = 0;
+        while (!m_hit[h] || m_owner[h] >= 0)
+            h++;
+        for (int s = 0; s < nShips; s++)
+        {
+            if (m_current[s].start < 0 &&
+                !forEachPlacementCovering(m_rows, m_cols, m_lengths[s], h, place(s)))
+                return false;
+        }
+        return true;
+    }
+    for (int s = 0; s < nShips; s++)
+    {
+        if (m_current[s].start >= 0)
+            continue;
+        return forEachPlacement(m_rows, m_cols, m_lengths[s], place(s));
+    }
+    addLayout();
+    return static_cast<int>(m_alive.size()) <= m_maxLayouts;
+}
+
+// Place ship shipId at p, a placement on the board, and extend, if p is
+// clear of misses and other ships and fits what is known of the ship;
+// false once a limit is hit
+bool EndgameSolver::tryPlacement(int shipId, Placement p, int uncoveredHits, int lengthLeft)
+{
+    int len = m_lengths[shipId];
+    int sunkAt = m_sunkAt[shipId];
+    bool coversSink = false;
+    int hitCells = 0;
+    for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+    {
+        if (m_miss[cell] || m_owner[cell] >= 0)
+            return true;
+        hitCells += m_hit[cell];
+        coversSink = coversSink || cell == sunkAt;
+    }
+    //a sunk ship lies on hits only; one afloat still has an unhit cell
+    if (sunkAt >= 0 ? hitCells < len || !coversSink : hitCells == len)
+        return true;
+    for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+        m_owner[cell] = shipId;
+    m_current[shipId] = p;
+    bool more = extend(uncoveredHits - hitCells, lengthLeft - len);
+    for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+        m_owner[cell] = -1;
+    m_current[shipId] = Placement();
+    return more;
+}
+
+// Keep the layout in m_current if replaying the results on it gives the
+// same answers, sinkings included
+void EndgameSolver::addLayout()
+{
+    int layout = m_layouts.size() / m_lengths.size();
+    m_layouts.insert(m_layouts.end(), m_current.begin(), m_current.end());
+    m_searchHit.assign(m_cells, 0);
+    for (size_t k = 0; k < m_shots.size(); k++)
+    {
+        if (!agrees(layout, m_shots[k], m_searchHit))
+        {
+            m_layouts.resize(layout * m_lengths.size());
+            return;
+        }
+        if (m_shots[k].hit)
+            m_searchHit[m_shots[k].cell] = 1;
+    }
+    m_alive.push_back(layout);
+}
+
+//*********************************************************************
+//  Transposition table
+//*********************************************************************
+
+bool EndgameSolver::lookUp(Key key, double& v) const
+{
+    if (m_slots.empty())
+        return false;
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = key.a & mask; m_slots[i].stamp == m_stamp; i = (i + 1) & mask)
+    {
+        if (m_slots[i].key == key)
+        {
+            v = m_slots[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Linear probing in a table kept at most half full: it doubles until it
+// would hold more than TABLE_LIMIT positions, and is emptied after that
+void EndgameSolver::store(Key key, double v)
+{
+    if (2 * (m_stored + 1) > m_slots.size())
+    {
+        if (m_slots.size() >= 2 * TABLE_LIMIT)
+            clearTable();
+        else
+        {
+            vector<Slot> old;
+            old.swap(m_slots);
+            unsigned oldStamp = m_stamp;
+            m_slots.assign(old.empty() ? FIRST_SLOTS : 2 * old.size(), Slot());
+            m_stamp = 1;
+            m_stored = 0;
+            for (size_t i = 0; i < old.size(); i++)
+            {
+                if (old[i].stamp == oldStamp)
+                    store(old[i].key, old[i].value);
+            }
+        }
+    }
+    size_t mask = m_slots.size() - 1;
+    size_t i = key.a & mask;
+    while (m_slots[i].stamp == m_stamp && !(m_slots[i].key == key))
+        i = (i + 1) & mask;
+    if (m_slots[i].stamp != m_stamp)
+    {
+        m_slots[i].key = key;
+        m_slots[i].stamp = m_stamp;
+        m_stored++;
+    }
+    m_slots[i].value = v;
+}
+
+// A new stamp empties every slot at once; only when the stamps run out are
+// they all rewritten
+void EndgameSolver::clearTable()
+{
+    m_stored = 0;
+    if (++m_stamp == 0)
+    {
+        for (size_t i = 0; i < m_slots.size(); i++)
+            m_slots[i].stamp = 0;
+        m_stamp = 1;
+    }
+}
+
+//*********************************************************************
+//  Search
+//*********************************************************************
+
+bool EndgameSolver::solve(Point& shot, double& expectedShots)
+{
+    if (!m_listed)
+    {
+        //on a big board that waits until most cells are known
+        if (m_unknown > static_cast<long long>(UNKNOWN_PER_LAYOUT) * m_maxLayouts)
+            return false;
+        //after each failed listing wait twice as many results as last time
+        //before trying again, so a long game pays for only a few of them
+        if (m_listWait > 0)
+            return false;
+        if (!listLayouts())
+        {
+            m_listWait = m_listBackoff;
+            m_listBackoff *= 2;
+            return false;
+        }
+    }
+    //a search that ran out of work is not tried again until the layouts
+    //left have halved
+    if (m_alive.empty() || static_cast<int>(m_alive.size()) > m_retryAt)
+        return false;
+    m_searchHit = m_hit;
+    Key hitKey;
+    Key aliveKey;
+    for (int cell = 0; cell < m_cells; cell++)
+    {
+        if (m_hit[cell])
+            hitKey = hitKey ^ m_zHit[cell];
+    }
+    for (size_t k = 0; k < m_alive.size(); k++)
+        aliveKey = aliveKey ^ m_zLayout[m_alive[k]];
+    m_work = 0;
+    m_aborted = false;
+    m_depth = 0;
+    int cell;
+    double v = bestShot(m_alive, hitKey, cell);
+    if (m_aborted)
+        m_retryAt = m_alive.size() / 2;
+    if (m_aborted || cell < 0)
+        return false;
+    store(hitKey ^ aliveKey, v);
+    shot = Point(cell / m_cols, cell % m_cols);
+    expectedShots = v;
+    return true;
+}
+
+double EndgameSolver::value(const vector<int>& alive, Key hitKey, Key aliveKey)
+{
+    Key key = hitKey ^ aliveKey;
+    double v;
+    if (lookUp(key, v))
+        return v;
+    m_work += alive.size();
+    if (m_work > m_maxWork)
+    {
+        m_aborted = true;
+        return 0;
+    }
+    int cell;
+    m_depth++;
+    v = bestShot(alive, hitKey, cell);
+    m_depth--;
+    if (!m_aborted)
+        store(key, v);
+    return v;
+}
+
+double EndgameSolver::bestShot(const vector<int>& alive, Key hitKey, int& bestCell)
+{
+    int n = alive.size();
+    int nShips = m_lengths.size();
+    bestCell = -1;
+    //with one layout left, shoot its unhit cells in any order
+    if (n == 1)
+    {
+        int unhit = unhitCells(alive[0], m_searchHit);
+        for (int s = 0; s < nShips && bestCell < 0; s++)
+        {
+            Placement p = m_layouts[alive[0] * nShips + s];
+            for (int k = 0, c = p.start; k < m_lengths[s] && bestCell < 0; k++, c += p.step)
+            {
+                if (!m_searchHit[c])
+                    bestCell = c;
+            }
+        }
+        return unhit;
+    }
+
+    //this depth's lists, kept from earlier searches
+    if (static_cast<int>(m_frames.size()) <= m_depth)
+        m_frames.resize(m_depth + 1);
+    Frame& f = m_frames[m_depth];
+    vector<int>& count = f.count;
+    vector<int>& unhit = f.unhit;
+    vector<int>& candidates = f.candidates;
+    vector<vector<int> >& outcome = f.outcome;
+    vector<Key>& outcomeKey = f.outcomeKey;
+    vector<int>& fewestLeft = f.fewestLeft;
+
+    //how many layouts put a ship on each unhit cell
+    count.assign(m_cells, 0);
+    unhit.resize(n);
+    for (int j = 0; j < n; j++)
+    {
+        unhit[j] = 0;
+        for (int s = 0; s < nShips; s++)
+        {
+            Placement p = m_layouts[alive[j] * nShips + s];
+            for (int k = 0, c = p.start; k < m_lengths[s]; k++, c += p.step)
+            {
+                if (!m_searchHit[c])
+                {
+                    count[c]++;
+                    unhit[j]++;
+                }
+            }
+        }
+    }
+    //a cell every layout has a ship on must be shot sooner or later, and
+    //shooting it now only tells us more, so it is the only shot to try;
+    //otherwise try the likeliest hits first to find a good bound early
+    candidates.clear();
+    for (int c = 0; c < m_cells; c++)
+    {
+        if (count[c] == n)
+        {
+            candidates.assign(1, c);
+            break;
+        }
+        if (count[c] > 0)
+            candidates.push_back(c);
+    }
+    //ties stay in cell order, as a stable sort would leave them, but
+    //without the stable sort's temporary buffer
+    sort(candidates.begin(), candidates.end(),
+        [&](int x, int y) { return count[x] != count[y] ? count[x] > count[y] : x < y; });
+
+    // Outcome 0 is a miss, 1 a hit, 2 + s the sinking of ship s with more
+    // ships afloat; a shot that sinks the last ship ends the game
+    int nOutcomes = 2 + nShips;
+    outcome.resize(nOutcomes);
+    outcomeKey.resize(nOutcomes);
+    fewestLeft.resize(nOutcomes);
+    double best = 0;
+    for (size_t k = 0; k < candidates.size(); k++)
+    {
+        int x = candidates[k];
+        m_work += n;
+        if (m_work > m_maxWork)
+        {
+            m_aborted = true;
+            return 0;
+        }
+        for (int o = 0; o < nOutcomes; o++)
+        {
+            outcome[o].clear();
+            outcomeKey[o] = Key();
+            fewestLeft[o] = m_cells;
+        }
+        for (int j = 0; j < n; j++)
+        {
+            int layout = alive[j];
+            int s = shipAt(layout, x);
+            int left = unhit[j] - (s >= 0);
+            int o = (s < 0 ? 0 : !sinks(layout, x, m_searchHit) ? 1 : left == 0 ? -1 : 2 + s);
+            if (o < 0)
+                continue;
+            outcome[o].push_back(layout);
+            outcomeKey[o] = outcomeKey[o] ^ m_zLayout[layout];
+            fewestLeft[o] = min(fewestLeft[o], left);
+        }
+        //every ship cell left must still be shot, so each outcome costs at
+        //least its fewest unhit cells
+        double bound = 0;
+        for (int o = 0; o < nOutcomes; o++)
+            bound += double(outcome[o].size()) / n * (outcome[o].empty() ? 0 : fewestLeft[o]);
+        if (bestCell >= 0 && 1 + bound >= best - EPSILON)
+            continue;
+        double v = 1;
+        bool cut = false;
+        for (int o = 0; o < nOutcomes && !cut; o++)
+        {
+            if (outcome[o].empty())
+                continue;
+            double weight = double(outcome[o].size()) / n;
+            bound -= weight * fewestLeft[o];
+            m_searchHit[x] = (o > 0);
+            v += weight * value(outcome[o], o > 0 ? hitKey ^ m_zHit[x] : hitKey, outcomeKey[o]);
+            m_searchHit[x] = 0;
+            if (m_aborted)
+                return 0;
+            cut = (bestCell >= 0 && v + bound >= best - EPSILON);
+        }
+        if (!cut)
+        {
+            best = v;
+            bestCell = x;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,146 @@
+#ifndef ENDGAMESOLVER_INCLUDED
+#define ENDGAMESOLVER_INCLUDED
+
+#include "globals.h"
+#include "ShipPlacement.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class Game;
+
+// Finds the shot that minimizes the expected number of shots still needed
+// to sink the opponent's fleet, counting every fleet layout that agrees
+// with the results so far as equally likely.  This is only practical once
+// few layouts are left -- on a small board, or late in a game on a big
+// one -- so solve gives up beyond fixed limits and the caller falls back
+// to its usual targeting.  On a board with many times more unknown cells
+// than layouts allowed it does not even try.
+//
+// The layouts are listed the first time there are few enough, and each
+// later result just strikes out those that disagree with it.  The search
+// runs over positions made of the cells hit and the layouts still
+// possible (which between them fix the misses and the ships sunk), and
+// keeps the value of every position it finishes in a transposition table
+// keyed on a Zobrist hash of both.  The table lasts for the whole game, so
+// after the first solve most moves are looked up.
+//
+// The table and the search's per-depth lists keep their storage from one
+// solve to the next and across reset, so a solver that has already been
+// through a game allocates nothing when it goes through one like it.
+class EndgameSolver
+{
+public:
+    // Give up when more than maxLayouts layouts are consistent, or when
+    // listing them or a solve would take more than maxWork steps (one step
+    // per layout looked at for a position or a shot tried there)
+    EndgameSolver(const Game& g, int maxLayouts = 1024, long long maxWork = 1000000);
+    // Record the result of attacking p, as passed to recordAttackResult
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+    // Forget every result, as if newly constructed
+    void reset();
+    // Set shot to the best next shot and expectedShots to the expected
+    // number of shots, that one included, left until the fleet is sunk.
+    // Returns false, leaving both alone, if the limits were hit.
+    bool solve(Point& shot, double& expectedShots);
+
+private:
+    // A result as passed to record
+    struct Shot
+    {
+        int cell;
+        bool hit;
+        bool destroyed;
+        int shipId;
+    };
+    // A position: the Zobrist hashes of its hit cells and its layouts,
+    // combined, in two independent streams
+    struct Key
+    {
+        Key() : a(0), b(0) {}
+        Key(uint64_t aa, uint64_t bb) : a(aa), b(bb) {}
+        Key operator^(const Key& other) const { return Key(a ^ other.a, b ^ other.b); }
+        uint64_t a;
+        uint64_t b;
+        bool operator==(const Key& other) const { return a == other.a && b == other.b; }
+    };
+    // A slot of the transposition table, in use if its stamp is the table's
+    struct Slot
+    {
+        Key key;
+        double value;
+        unsigned stamp;
+    };
+    // What bestShot works with at one depth of the search
+    struct Frame
+    {
+        std::vector<int> count;                 // per cell
+        std::vector<int> unhit;                 // per layout
+        std::vector<int> candidates;
+        std::vector<std::vector<int> > outcome; // per outcome, its layouts
+        std::vector<Key> outcomeKey;            // per outcome
+        std::vector<int> fewestLeft;            // per outcome
+    };
+
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    int m_cells;
+    int m_maxLayouts;
+    long long m_maxWork;
+    std::vector<int> m_lengths;             // per ship
+    std::vector<Shot> m_shots;              // every result, in order
+    std::vector<char> m_hit;                // per cell, a hit so far
+    std::vector<char> m_miss;               // per cell, a miss so far
+    int m_unknown;                          // cells neither hit nor missed
+
+    bool m_listed;                          // m_layouts holds every consistent layout
+    int m_listWait;                         // results to record before listing again
+    int m_listBackoff;                      // the wait after the next failed listing
+    std::vector<Placement> m_layouts;       // nShips per layout
+    std::vector<int> m_alive;               // layouts consistent with every result
+    std::vector<Key> m_zLayout;             // per layout
+    std::vector<Key> m_zHit;                // per cell
+
+    std::vector<Slot> m_slots;              // a power of two of them, once used
+    unsigned m_stamp;                       // of the slots in use
+    size_t m_stored;                        // positions in the table
+    std::vector<char> m_searchHit;          // per cell, hit in the position searched
+    std::deque<Frame> m_frames;             // per depth; growing keeps the others in place
+    int m_depth;                            // of the position bestShot is at
+    long long m_work;
+    bool m_aborted;
+    int m_retryAt;                          // most layouts worth searching again
+
+    // Scratch for listing layouts
+    std::vector<int> m_owner;               // per cell
+    std::vector<Placement> m_current;       // per ship, start -1 if not placed
+    std::vector<int> m_sunkAt;              // per ship, the cell that sank it, or -1
+
+    // Ship of layout on cell, or -1
+    int shipAt(int layout, int cell) const;
+    // Does layout agree with shot, given the cells hit before it?
+    bool agrees(int layout, const Shot& shot, const std::vector<char>& hitBefore) const;
+    // Unhit ship cells of layout, and whether shooting cell (a hit) sinks its ship
+    int unhitCells(int layout, const std::vector<char>& hit) const;
+    bool sinks(int layout, int cell, const std::vector<char>& hit) const;
+
+    bool listLayouts();
+    bool extend(int uncoveredHits, int lengthLeft);
+    bool tryPlacement(int shipId, Placement p, int uncoveredHits, int lengthLeft);
+    void addLayout();
+
+    // The value of the position with key, if the table has it
+    bool lookUp(Key key, double& v) const;
+    void store(Key key, double v);
+    void clearTable();
+
+    // Expected shots left from the position (alive, m_searchHit), whose
+    // hit cells and layouts hash to hitKey and aliveKey
+    double value(const std::vector<int>& alive, Key hitKey, Key aliveKey);
+    // The best shot from that position and its value; bestCell is -1 if
+    // the fleet is already sunk
+    double bestShot(const std::vector<int>& alive, Key hitKey, int& bestCell);
+};
+
+#endif // ENDGAMESOLVER_INCLUDED
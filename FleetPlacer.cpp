@@ -0,0 +1,388 @@
+#include "FleetPlacer.h"
+#include "Board.h"
+#include "Game.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+FleetPlacer::FleetPlacer(const Game& g)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()), m_freeLeft(0), m_cellsLeft(0)
+{}
+
+bool FleetPlacer::placeShips(Board& b, Rng& rng)
+{
+    setUp();
+    int nShips = m_lengths.size();
+    fill(m_triesLeft.begin(), m_triesLeft.end(), static_cast<int>(TRIES_PER_SHIP));
+    m_runAcross.clear();
+    m_runDown.clear();
+    bool found = drawIndependent(b, rng);
+    if (!found)
+    {
+        //no need to search if some ship has nowhere to go at all
+        bool possible = true;
+        for (int s = 0; s < nShips && possible; s++)
+        {
+            listOptions(b, s);
+            possible = !m_options[s].empty();
+        }
+        found = possible && search(b, rng);
+    }
+    if (!found)
+        return false;
+    for (int s = 0; s < nShips; s++)
+    {
+        Point topOrLeft(m_layout[s].start / m_cols, m_layout[s].start % m_cols);
+        Direction dir = (m_layout[s].step == 1 ? HORIZONTAL : VERTICAL);
+        if (!b.placeShip(topOrLeft, s, dir))
+        {
+            //cannot happen for a board with only free cells checked above,
+            //but leave b as it was if it does
+            for (int t = 0; t < s; t++)
+            {
+                b.unplaceShip(Point(m_layout[t].start / m_cols, m_layout[t].start % m_cols),
+                    t, m_layout[t].step == 1 ? HORIZONTAL : VERTICAL);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+// Make the per-ship tables for the game's fleet, unless they are already
+// up to date.  The search's tables are left until it is needed.
+void FleetPlacer::setUp()
+{
+    int nShips = m_game.nShips();
+    if (static_cast<int>(m_lengths.size()) == nShips)
+        return;
+    //ships may have been added to the game since the tables were made
+    m_lengths.resize(nShips);
+    for (int s = 0; s < nShips; s++)
+        m_lengths[s] = m_game.shipLength(s);
+    m_layout.assign(nShips, Placement());
+    m_triesLeft.assign(nShips, 0);
+    m_options.clear();
+    m_groupLength.clear();
+    m_groupShips.clear();
+    if (m_owner.empty())
+        m_owner.assign(m_rows * m_cols, -1);
+}
+
+// Sort the ships into groups of one length, for the search
+void FleetPlacer::setUpGroups()
+{
+    if (!m_groupLength.empty())
+        return;
+    for (size_t s = 0; s < m_lengths.size(); s++)
+    {
+        size_t g = 0;
+        while (g < m_groupLength.size() && m_groupLength[g] != m_lengths[s])
+            g++;
+        if (g == m_groupLength.size())
+        {
+            m_groupLength.push_back(m_lengths[s]);
+            m_groupShips.push_back(vector<int>());
+        }
+        m_groupShips[g].push_back(s);
+    }
+    m_groupLeft.assign(m_groupLength.size(), 0);
+}
+
+void FleetPlacer::listOptions(const Board& b, int shipId)
+{
+    if (m_triesLeft[shipId] < 0)
+        return;
+    m_triesLeft[shipId] = -1;
+    m_options.resize(m_lengths.size());
+    if (m_runAcross.empty())
+    {
+        //lengths of the runs of free cells starting at each cell, going
+        //right and going down
+        m_runAcross.assign(m_owner.size(), 0);
+        m_runDown.assign(m_owner.size(), 0);
+        for (int r = m_rows - 1; r >= 0; r--)
+        {
+            for (int c = m_cols - 1; c >= 0; c--)
+            {
+                int cell = r * m_cols + c;
+                if (!b.isFree(Point(r, c)))
+                    continue;
+                m_runAcross[cell] = 1 + (c + 1 < m_cols ? m_runAcross[cell + 1] : 0);
+                m_runDown[cell] = 1 + (r + 1 < m_rows ? m_runDown[cell + m_cols] : 0);
+            }
+        }
+    }
+    m_options[shipId].clear();
+    int len = m_lengths[shipId];
+    forEachPlacement(m_rows, m_cols, len, [&](Placement p)
+    {
+        if ((p.step == 1 ? m_runAcross : m_runDown)[p.start] >= len)
+            m_options[shipId].push_back(p);
+        return true;
+    });
+}
+
+// A uniformly random placement of a ship on free cells: in-bounds
+// placements are drawn until one is free, and once that has failed too
+// often (a crowded board) the free ones are listed and drawn from
+// directly.  Start -1 if there are none.
+Placement FleetPlacer::drawShip(const Board& b, int shipId, Rng& rng)
+{
+    int len = m_lengths[shipId];
+    int n = countPlacements(m_rows, m_cols, len);
+    while (m_triesLeft[shipId] > 0 && n > 0)
+    {
+        m_triesLeft[shipId]--;
+        Placement p = placementAt(m_rows, m_cols, len, rng.randInt(n));
+        bool free = true;
+        for (int j = 0, cell = p.start; j < len && free; j++, cell += p.step)
+            free = b.isFree(Point(cell / m_cols, cell % m_cols));
+        if (free)
+            return p;
+    }
+    listOptions(b, shipId);
+    if (m_options[shipId].empty())
+        return Placement();
+    return m_options[shipId][rng.randInt(m_options[shipId].size())];
+}
+
+// Give each ship an independent uniformly random placement on free cells,
+// and start over whenever two ships overlap
+bool FleetPlacer::drawIndependent(const Board& b, Rng& rng)
+{
+    int nShips = m_lengths.size();
+    for (int draw = 0; draw < DRAWS; draw++)
+    {
+        int placed = 0;
+        bool overlap = false;
+        while (placed < nShips && !overlap)
+        {
+            Placement p = drawShip(b, placed, rng);
+            if (p.start < 0)
+                break;
+            overlap = !fits(placed, p);
+            if (!overlap)
+            {
+                m_layout[placed] = p;
+                put(placed, p, placed);
+                placed++;
+            }
+        }
+        for (int s = 0; s < placed; s++)
+            put(s, m_layout[s], -1);
+        if (placed == nShips)
+            return true;
+        if (!overlap)
+            return false;       //some ship has no free placement at all
+    }
+    return false;
+}
+
+// Fill the free cells of b in reading order, on the board mirrored at
+// random, deciding for each one to leave it empty or to start a ship of a
+// length still to place there.  On success m_layout holds the fleet.
+bool FleetPlacer::search(const Board& b, Rng& rng)
+{
+    setUpGroups();
+    int nCells = m_rows * m_cols;
+    bool flipRows = (rng.randInt(2) == 1);
+    bool flipCols = (rng.randInt(2) == 1);
+    m_state.assign(nCells, EMPTY);
+    m_freeLeft = 0;
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        int r = cell / m_cols;
+        int c = cell % m_cols;
+        if (b.isFree(Point(flipRows ? m_rows - 1 - r : r, flipCols ? m_cols - 1 - c : c)))
+        {
+            m_state[cell] = UNDECIDED;
+            m_freeLeft++;
+        }
+    }
+    m_cellsLeft = 0;
+    for (size_t g = 0; g < m_groupLength.size(); g++)
+    {
+        m_groupLeft[g] = m_groupShips[g].size();
+        m_cellsLeft += m_groupLength[g] * m_groupLeft[g];
+    }
+    m_steps.clear();
+    m_choices.clear();
+    m_found.clear();
+    m_foundGroup.clear();
+
+    int nShips = m_lengths.size();
+    long long budget = SEARCH_BUDGET;
+    int cell = 0;
+    while (static_cast<int>(m_found.size()) < nShips)
+    {
+        while (cell < nCells && m_state[cell] != UNDECIDED)
+            cell++;
+        if (--budget < 0)
+            return false;
+        expand(cell, rng);
+        //take the next choice left, going back as far as needed
+        bool moved = false;
+        while (!moved && !m_steps.empty())
+        {
+            Step& s = m_steps.back();
+            if (s.applied)
+            {
+                undo(s.cell, m_choices[s.firstChoice + s.nextChoice - 1]);
+                s.applied = false;
+            }
+            if (s.nextChoice < s.nChoices)
+            {
+                apply(s.cell, m_choices[s.firstChoice + s.nextChoice]);
+                s.nextChoice++;
+                s.applied = true;
+                cell = s.cell + 1;
+                moved = true;
+            }
+            else
+            {
+                m_choices.resize(s.firstChoice);
+                m_steps.pop_back();
+            }
+        }
+        if (!moved)
+            return false;
+    }
+
+    //hand each length's placements to its ships in random order, and
+    //undo the mirroring
+    for (size_t g = 0; g < m_groupShips.size(); g++)
+    {
+        vector<int>& ships = m_groupShips[g];
+        for (int k = ships.size() - 1; k > 0; k--)
+            swap(ships[k], ships[rng.randInt(k + 1)]);
+        m_groupLeft[g] = 0;
+    }
+    for (int k = 0; k < nShips; k++)
+    {
+        int g = m_foundGroup[k];
+        int shipId = m_groupShips[g][m_groupLeft[g]++];
+        int len = m_groupLength[g];
+        Placement p = m_found[k];
+        int r = p.start / m_cols;
+        int c = p.start % m_cols;
+        int lastR = (p.step == 1 ? r : r + len - 1);
+        int lastC = (p.step == 1 ? c + len - 1 : c);
+        r = (flipRows ? m_rows - 1 - lastR : r);
+        c = (flipCols ? m_cols - 1 - lastC : c);
+        m_layout[shipId] = Placement(r * m_cols + c, p.step);
+    }
+    return true;
+}
+
+// Push a step for cell with its choices in random order: a ship of each
+// length still to place that fits across or down from there, and leaving
+// the cell empty if the ships left fit in fewer cells than are free.
+// There are none past the last cell or once the ships left cannot fit.
+void FleetPlacer::expand(int cell, Rng& rng)
+{
+    Step s;
+    s.cell = cell;
+    s.firstChoice = m_choices.size();
+    s.nextChoice = 0;
+    s.applied = false;
+    int nCells = m_rows * m_cols;
+    if (cell < nCells && m_freeLeft >= m_cellsLeft)
+    {
+        int r = cell / m_cols;
+        int c = cell % m_cols;
+        for (size_t g = 0; g < m_groupLength.size(); g++)
+        {
+            if (m_groupLeft[g] == 0)
+                continue;
+            int len = m_groupLength[g];
+            if (c + len <= m_cols && fitsSearch(cell, len, 1))
+                m_choices.push_back(g * 2);
+            //a one-cell ship placed down is the same as placed across
+            if (len > 1 && r + len <= m_rows && fitsSearch(cell, len, m_cols))
+                m_choices.push_back(g * 2 + 1);
+        }
+        //random order by Fisher-Yates
+        int nShips = m_choices.size() - s.firstChoice;
+        for (int k = nShips - 1; k > 0; k--)
+            swap(m_choices[s.firstChoice + k], m_choices[s.firstChoice + rng.randInt(k + 1)]);
+        //leave the cell empty first about as often as a free cell ends up
+        //empty
+        int slack = m_freeLeft - m_cellsLeft;
+        if (slack > 0)
+        {
+            m_choices.push_back(EMPTY);
+            if (nShips > 0 && rng.randInt(m_freeLeft) < slack)
+                swap(m_choices[s.firstChoice], m_choices.back());
+        }
+    }
+    s.nChoices = m_choices.size() - s.firstChoice;
+    m_steps.push_back(s);
+}
+
+bool FleetPlacer::fitsSearch(int cell, int len, int step) const
+{
+    for (int k = 0; k < len; k++, cell += step)
+    {
+        if (m_state[cell] != UNDECIDED)
+            return false;
+    }
+    return true;
+}
+
+void FleetPlacer::apply(int cell, int choice)
+{
+    if (choice == EMPTY)
+    {
+        m_state[cell] = EMPTY;
+        m_freeLeft--;
+        return;
+    }
+    int g = choice / 2;
+    int len = m_groupLength[g];
+    int step = (choice % 2 == 1 ? m_cols : 1);
+    for (int k = 0, c = cell; k < len; k++, c += step)
+        m_state[c] = g;
+    m_freeLeft -= len;
+    m_cellsLeft -= len;
+    m_groupLeft[g]--;
+    m_found.push_back(Placement(cell, step));
+    m_foundGroup.push_back(g);
+}
+
+void FleetPlacer::undo(int cell, int choice)
+{
+    if (choice == EMPTY)
+    {
+        m_state[cell] = UNDECIDED;
+        m_freeLeft++;
+        return;
+    }
+    int g = choice / 2;
+    int len = m_groupLength[g];
+    int step = (choice % 2 == 1 ? m_cols : 1);
+    for (int k = 0, c = cell; k < len; k++, c += step)
+        m_state[c] = UNDECIDED;
+    m_freeLeft += len;
+    m_cellsLeft += len;
+    m_groupLeft[g]++;
+    m_found.pop_back();
+    m_foundGroup.pop_back();
+}
+
+bool FleetPlacer::fits(int shipId, Placement p) const
+{
+    for (int k = 0, cell = p.start; k < m_lengths[shipId]; k++, cell += p.step)
+    {
+        if (m_owner[cell] >= 0)
+            return false;
+    }
+    return true;
+}
+
+void FleetPlacer::put(int shipId, Placement p, int owner)
+{
+    for (int k = 0, cell = p.start; k < m_lengths[shipId]; k++, cell += p.step)
+        m_owner[cell] = owner;
+}
@@ -0,0 +1,101 @@
+#ifndef FLEETPLACER_INCLUDED
+#define FLEETPLACER_INCLUDED
+
+#include "globals.h"
+#include "ShipPlacement.h"
+#include <vector>
+
+class Board;
+class Game;
+
+// Lays out a whole fleet at random on the free cells of a board.
+//
+// A layout is first drawn by giving every ship an independent, uniformly
+// random placement on free cells and starting over if two ships overlap.
+// Conditioned on no overlap that is exactly uniform over the valid
+// layouts, and on ordinary boards it succeeds within a few tries.
+//
+// Dense fleets and crowded boards, where that almost never succeeds, fall
+// back to a depth-first search that fills the free cells in reading
+// order: each one is either left empty or made the top or left end of a
+// ship of some length still to place.  Ships of the same length are
+// interchangeable there, and a branch is dropped as soon as the free
+// cells left cannot hold the ships left, so the search finds a layout of
+// fleets that have one, up to the board's fill limit, well within its
+// budget of steps.  Its layouts are random but not uniform: the board is
+// mirrored at random, a cell is left empty first with a chance equal to
+// the share of free cells that must stay empty, lengths are tried in
+// random order and ships of equal length swap places at random, but a
+// layout below a choice with few completions is drawn more often than
+// one below a choice with many.
+//
+// A ship's placements are only listed once drawing it at random keeps
+// landing on cells that are not free, so sparse fleets on big boards never
+// pay for the listing.
+class FleetPlacer
+{
+public:
+    FleetPlacer(const Game& g);
+    // Place every ship of the game on b using only cells that are free.
+    // Returns false, leaving b unchanged, if no layout exists or none was
+    // found within the work limits.
+    bool placeShips(Board& b, Rng& rng);
+
+private:
+    // Independent draws of a whole fleet, and random tries at a free
+    // placement a ship gets before its free placements are listed
+    enum { DRAWS = 64, TRIES_PER_SHIP = 16 };
+    // Cells the search may decide, counting those it goes back on
+    enum { SEARCH_BUDGET = 4000000 };
+    // What the search knows of a cell that holds no ship
+    enum { UNDECIDED = -1, EMPTY = -2 };
+
+    // A cell the search has decided and the choices it has left there
+    struct Step
+    {
+        int cell;
+        int firstChoice;        // its choices are m_choices from here
+        int nChoices;
+        int nextChoice;
+        bool applied;           // choice nextChoice - 1 is in place
+    };
+
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    // Tables set up for the game's fleet, redone if ships are added
+    std::vector<int> m_lengths;             // per ship
+    std::vector<int> m_groupLength;         // the distinct ship lengths, once searched
+    std::vector<std::vector<int> > m_groupShips;    // per length, its ships
+    // The independent draws' tables
+    std::vector<Placement> m_layout;        // per ship, once found
+    std::vector<int> m_owner;               // ship on each cell, or -1
+    std::vector<int> m_triesLeft;           // per ship in this placeShips call, -1 once listed
+    std::vector<int> m_runAcross;           // free cells from each cell rightwards,
+    std::vector<int> m_runDown;             // and downwards; empty until needed
+    std::vector<std::vector<Placement> > m_options;     // per ship listed, on free cells
+    // The search's tables, on the board as mirrored for this search
+    std::vector<int> m_state;               // length index on each cell, UNDECIDED or EMPTY
+    std::vector<int> m_groupLeft;           // per length, ships still to place
+    std::vector<Step> m_steps;
+    std::vector<int> m_choices;             // EMPTY, or twice a length index, plus 1 for down
+    std::vector<Placement> m_found;         // ships placed so far,
+    std::vector<int> m_foundGroup;          // and their length indexes
+    int m_freeLeft;                         // UNDECIDED cells
+    int m_cellsLeft;                        // cells of the ships still to place
+
+    void setUp();
+    void setUpGroups();
+    void listOptions(const Board& b, int shipId);
+    Placement drawShip(const Board& b, int shipId, Rng& rng);
+    bool drawIndependent(const Board& b, Rng& rng);
+    bool search(const Board& b, Rng& rng);
+    void expand(int cell, Rng& rng);
+    bool fitsSearch(int cell, int len, int step) const;
+    void apply(int cell, int choice);
+    void undo(int cell, int choice);
+    bool fits(int shipId, Placement p) const;
+    void put(int shipId, Placement p, int owner);
+};
+
+#endif // FLEETPLACER_INCLUDED
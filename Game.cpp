@@ -1,11 +1,13 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
+#include "GameObserver.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <algorithm>
 #include <vector>
 
 using namespace std;
@@ -13,16 +15,23 @@ using namespace std;
 class GameImpl
 {
 public:
-    GameImpl(int nRows, int nCols);
+    GameImpl(int nRows, int nCols, unsigned long long seed);
+    ~GameImpl();
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+    int randInt(int limit) const;
+    unsigned long long seed() const;
+    void reseed(unsigned long long seed);
+    unsigned long long nextSeed() const;
+    void setSalvo(int shots);
+    int salvo() const;
     bool addShip(int length, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    string shipName(int shipId) const;
+    const string& shipName(int shipId) const;
     //Ship objects will store data about newly created ship types 
     class Ship
     {
@@ -33,21 +42,39 @@ public:
         char ship_symbol; 
         string ship_name; 
     };
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, ostream* out, bool shouldPause);
+    // Board k (0 or 1) of game g, which owns this GameImpl, ready for a new
+    // game; made on first use and reset after that
+    Board& board(int k, const Game& g);
+    void reportAttack(Player* attacker, Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    void addObserver(GameObserver* o);
+    void removeObserver(GameObserver* o);
 private: 
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2);
+    bool takeTurn(Player* attacker, Player* defender, const Board& own, Board& b, int turnNumber);
+    void fire(Player* attacker, Player* defender, Board& b, Point target);
+    int salvoSize(const Player* attacker, const Board& own) const;
+    void reportPlacements(const Player& owner, const Board& b);
     int game_rows; 
     int game_cols;
+    unsigned long long game_seed;
+    mutable Rng game_rng;
+    mutable unsigned long long seeds_issued;
     vector<Ship> ship_types; //dynamically allocated array that stores ship types 
+    vector<GameObserver*> observers; //notified of every event; empty for bare simulation
+    Board* game_boards[2]; //kept from one play to the next
+    int game_salvo; //shots per turn, or Game::ONE_PER_SHIP
+    vector<Point> salvo_shots; //a salvo turn's shots and their results, sized when play
+    vector<ShotResult> salvo_results; //starts for the largest salvo yet
 };
 
-void waitForEnter()
-{
-    cout << "Press enter to continue: ";
-    cin.ignore(10000, '\n');
-}
-
-GameImpl::GameImpl(int nRows, int nCols) : game_rows(nRows), game_cols(nCols)
+GameImpl::GameImpl(int nRows, int nCols, unsigned long long seed)
+    : game_rows(nRows), game_cols(nCols), game_seed(seed),
+      game_rng(mixSeed(seed)), seeds_issued(0), game_salvo(1)
 {
+    game_boards[0] = nullptr;
+    game_boards[1] = nullptr;
    //Must not exceed MAXROWS and MAXCOLS
     if ((nRows > MAXROWS) || (nCols > MAXCOLS))
     {
@@ -55,6 +82,21 @@ GameImpl::GameImpl(int nRows, int nCols) : game_rows(nRows), game_cols(nCols)
     }
 }
 
+GameImpl::~GameImpl()
+{
+    delete game_boards[0];
+    delete game_boards[1];
+}
+
+Board& GameImpl::board(int k, const Game& g)
+{
+    if (game_boards[k] == nullptr)
+        game_boards[k] = new Board(g);
+    else
+        game_boards[k]->reset();
+    return *game_boards[k];
+}
+
 int GameImpl::rows() const
 {
     return game_rows; 
@@ -75,6 +117,29 @@ Point GameImpl::randomPoint() const
     return Point(randInt(rows()), randInt(cols()));
 }
 
+int GameImpl::randInt(int limit) const
+{
+    return game_rng.randInt(limit);
+}
+
+unsigned long long GameImpl::seed() const
+{
+    return game_seed;
+}
+
+void GameImpl::reseed(unsigned long long seed)
+{
+    game_seed = seed;
+    game_rng.seed(mixSeed(seed));
+    seeds_issued = 0;
+}
+
+unsigned long long GameImpl::nextSeed() const
+{
+    seeds_issued++;
+    return mixSeed(game_seed + seeds_issued);
+}
+
 bool GameImpl::addShip(int length, char symbol, string name)
 {
     if (length <= 0)//must be positive and must allow ship to fit into the board 
@@ -123,19 +188,133 @@ char GameImpl::shipSymbol(int shipId) const
     return ship_types[shipId].ship_symbol;
 }
 
-string GameImpl::shipName(int shipId) const
+const string& GameImpl::shipName(int shipId) const
 {
     if (shipId < 0 || shipId >= ship_types.size())
     {
+        static const string error = "error";
         cerr << "invalid shipId passed to shipName function";
-        return "error";
+        return error;
     }
     return ship_types[shipId].ship_name;
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+void GameImpl::addObserver(GameObserver* o)
+{
+    observers.push_back(o);
+}
+
+void GameImpl::removeObserver(GameObserver* o)
+{
+    for (size_t k = 0; k < observers.size(); k++)
+    {
+        if (observers[k] == o)
+        {
+            observers.erase(observers.begin() + k);
+            return;
+        }
+    }
+}
+
+void GameImpl::reportPlacements(const Player& owner, const Board& b)
+{
+    Point topOrLeft;
+    Direction dir;
+    for (int s = 0; s < nShips(); s++)
+    {
+        if (!b.shipPlacement(s, topOrLeft, dir))
+            continue;
+        for (size_t k = 0; k < observers.size(); k++)
+            observers[k]->shipPlaced(owner, b, s, topOrLeft, dir);
+    }
+}
+
+void GameImpl::setSalvo(int shots)
+{
+    game_salvo = shots;
+}
+
+int GameImpl::salvo() const
+{
+    return game_salvo;
+}
+
+// The shots attacker fires this turn, given its own board
+int GameImpl::salvoSize(const Player* attacker, const Board& own) const
+{
+    int shots = (game_salvo == Game::ONE_PER_SHIP ? own.shipsAfloat() : game_salvo);
+    int untried = rows() * cols() - attacker->knowledge().nTried();
+    return max(1, min(shots, untried));
+}
+
+// One attack by attacker on the defender's board b
+void GameImpl::fire(Player* attacker, Player* defender, Board& b, Point target)
+{
+    bool validAttack;
+    bool shotHit = false;
+    bool shipDestroyed = false;
+    int destroyedShipId = -1;
+    validAttack = b.attack(target, shotHit, shipDestroyed, destroyedShipId);
+    for (size_t k = 0; k < observers.size(); k++)
+        observers[k]->shotFired(*attacker, *defender, b, target, validAttack, shotHit, shipDestroyed, destroyedShipId);
+    reportAttack(attacker, target, validAttack, shotHit, shipDestroyed, destroyedShipId);
+}
+
+// One turn of attacker, whose board is own, on the defender's board b: a
+// single attack, or under salvo rules a batch of them resolved together
+// and then reported one by one.  Returns true if the turn sank the
+// defender's last ship.
+bool GameImpl::takeTurn(Player* attacker, Player* defender, const Board& own, Board& b, int turnNumber)
+{
+    for (size_t k = 0; k < observers.size(); k++)
+        observers[k]->turnStarted(*attacker, *defender, b);
+    int n = (game_salvo == 1 ? 1 : salvoSize(attacker, own));
+    if (n == 1)
+        fire(attacker, defender, b, attacker->recommendAttack());
+    else
+    {
+        attacker->recommendAttacks(&salvo_shots[0], n);
+        b.attackBatch(&salvo_shots[0], n, &salvo_results[0]);
+        for (int j = 0; j < n; j++)
+        {
+            const ShotResult& r = salvo_results[j];
+            for (size_t k = 0; k < observers.size(); k++)
+                observers[k]->shotFired(*attacker, *defender, b, salvo_shots[j], r.valid, r.hit, r.destroyed, r.shipId);
+            reportAttack(attacker, salvo_shots[j], r.valid, r.hit, r.destroyed, r.shipId);
+        }
+    }
+    for (size_t k = 0; k < observers.size(); k++)
+        observers[k]->turnEnded(*attacker, turnNumber);
+    return b.allShipsDestroyed();
+}
+
+void GameImpl::reportAttack(Player* attacker, Point p, bool validShot, bool shotHit,
+    bool shipDestroyed, int shipId)
+{
+    if (validShot)
+        attacker->m_knowledge.record(p, shotHit, shipDestroyed, shipId);
+    if (!attacker->isHuman())
+        attacker->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+// Play with the game's observers plus, if out is not null, commentary
+// written to out
+Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, ostream* out, bool shouldPause)
+{
+    if (out == nullptr)
+        return play(p1, p2, b1, b2);
+    ConsoleObserver console(*out, shouldPause);
+    observers.push_back(&console);
+    Player* winner = play(p1, p2, b1, b2);
+    removeObserver(&console);
+    return winner;
+}
+
+Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2)
 {
     //p1 will have the board b1 and p2 will have the board b2
+    p1->m_knowledge.clear();
+    p2->m_knowledge.clear();
     if (!(p1->placeShips(b1)))
     {
         return nullptr;
@@ -144,201 +323,44 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
     {
         return nullptr;
     }
-    bool validAttack;
-    bool shotHit;
-    bool shipDestroyed;
-    int destroyedShipId;
-    Point target; 
-    //b1 and b2 to be assembled by the 2 players (place ships) 
-    // while loop 
-        //p1 attack b2 
-        //display b2 board 
-        // //repeat code 
-        //p2 attack b1 
-        //display b1 board 
-    //keep repeating until win (exit condition for the while loop)
-    //should be while loop here
-    // assumes player algorithms will not make an invalid attack 
-    //should include recordAttackResult and recordAttackbyOpponent in this function 
-    while ((!(b1.allShipsDestroyed())) && (!(b2.allShipsDestroyed())))
+    if (!observers.empty())
     {
-        if (p1->isHuman())
-        {
-            cout << p1->name() + "'s turn. Board for " + p2->name() + ":";
-            cout << endl;
-            b2.display(true);
-        }
-        else
-        {
-            cout << p1->name() + "'s turn. Board for " + p2->name() + ":";
-            cout << endl;
-            b2.display(false);
-        }
-        target = p1->recommendAttack();
-        validAttack = b2.attack(target, shotHit, shipDestroyed, destroyedShipId);
-        if ((p1->isHuman()) && validAttack && shotHit)
-        {
-            if (shipDestroyed)
-            {
-                cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and destroyed the " + p1->game().shipName(destroyedShipId) + ", resulting in:";
-                cout << endl;
-                b2.display(true);
-            }
-            else
-            {
-                cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and hit something, resulting in:";
-                cout << endl;
-                b2.display(true);
-            }
-        }
-        else if ((p1->isHuman()) && validAttack && (!shotHit))
-        {
-            cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and missed, resulting in:"; 
-            cout << endl; 
-            b2.display(true); 
-        }
-        else if ((!(p1->isHuman())) && validAttack && shotHit)
-        {
-            if (shipDestroyed)
-            {
-                cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and destroyed the " + p1->game().shipName(destroyedShipId) + ", resulting in:";
-                cout << endl;
-                b2.display(false);
-                p1->recordAttackResult(target, true, true, true, destroyedShipId);
-            }
-            else
-            {
-                cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and hit something, resulting in:";
-                cout << endl;
-                b2.display(false);
-                p1->recordAttackResult(target, true, true, false, destroyedShipId);
-            }
-        }
-        else if ((!(p1->isHuman())) && validAttack && (!shotHit))
-        {
-            cout << p1->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and missed, resulting in:";
-            cout << endl;
-            b2.display(false);
-            p1->recordAttackResult(target, true, false, false, destroyedShipId);
-        }
-        else if ((p1->isHuman()) && !validAttack)
-        {
-            cout << p1->name() + " wasted a shot at (" + to_string(target.r) + "," + to_string(target.c) + ").";
-            cout << endl; 
-            b2.display(true);
-        }
-        else 
+        reportPlacements(*p1, b1);
+        reportPlacements(*p2, b2);
+    }
+    //a salvo never has more shots than the rules give or the board has
+    //cells; grown only here, so that no turn allocates
+    if (game_salvo != 1)
+    {
+        int most = min(game_salvo == Game::ONE_PER_SHIP ? nShips() : game_salvo, rows() * cols());
+        if (static_cast<int>(salvo_shots.size()) < most)
         {
-            cout << p1->name() + " wasted a shot at (" + to_string(target.r) + "," + to_string(target.c) + ").";
-            cout << endl; 
-            b2.display(false); 
-            p1->recordAttackResult(target, false, false, false, destroyedShipId);
+            salvo_shots.resize(most);
+            salvo_results.resize(most);
         }
-        if (b2.allShipsDestroyed())
+    }
+    // assumes player algorithms will not make an invalid attack 
+    //players alternate until one of them has no ships left
+    int turns = 0;
+    while ((!(b1.allShipsDestroyed())) && (!(b2.allShipsDestroyed())))
+    {
+        if (takeTurn(p1, p2, b1, b2, ++turns))
         {
             break; 
         }
-        if (shouldPause)
-        {
-            waitForEnter();
-        }
-
         //other player's turn 
-        if (p2->isHuman())
-        {
-            cout << p2->name() + "'s turn. Board for " + p1->name() + ":";
-            cout << endl;
-            b1.display(true);
-        }
-        else
-        {
-            cout << p2->name() + "'s turn. Board for " + p1->name() + ":";
-            cout << endl;
-            b1.display(false);
-        }
-        target = p2->recommendAttack();
-        validAttack = b1.attack(target, shotHit, shipDestroyed, destroyedShipId);
-        if ((p2->isHuman()) && validAttack && shotHit)
-        {
-            if (shipDestroyed)
-            {
-                cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and destroyed the " + p2->game().shipName(destroyedShipId) + ", resulting in:";
-                cout << endl;
-                b1.display(true);
-            }
-            else
-            {
-                cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and hit something, resulting in:";
-                cout << endl;
-                b1.display(true);
-            }
-        }
-        else if ((p2->isHuman()) && validAttack && (!shotHit))
-        {
-            cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and missed, resulting in:";
-            cout << endl;
-            b1.display(true);
-        }
-        else if ((!(p2->isHuman())) && validAttack && shotHit)
-        {
-            if (shipDestroyed)
-            {
-                cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and destroyed the " + p2->game().shipName(destroyedShipId) + ", resulting in:";
-                cout << endl;
-                b1.display(false);
-                p2->recordAttackResult(target, true, true, true, destroyedShipId);
-            }
-            else
-            {
-                cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and hit something, resulting in:";
-                cout << endl;
-                b1.display(false);
-                p2->recordAttackResult(target, true, true, false, destroyedShipId);
-            }
-        }
-        else if ((!(p2->isHuman())) && validAttack && (!shotHit))
-        {
-            cout << p2->name() + " attacked (" + to_string(target.r) + "," + to_string(target.c) + ") and missed, resulting in:";
-            cout << endl;
-            b1.display(false);
-            p2->recordAttackResult(target, true, false, false, destroyedShipId);
-        }
-        else if ((p2->isHuman()) && !validAttack)
-        {
-            cout << p2->name() + " wasted a shot at (" + to_string(target.r) + "," + to_string(target.c) + ").";
-            cout << endl;
-            b1.display(true);
-        }
-        else
-        {
-            cout << p2->name() + " wasted a shot at (" + to_string(target.r) + "," + to_string(target.c) + ").";
-            cout << endl;
-            b1.display(false);
-            p2->recordAttackResult(target, false, false, false, destroyedShipId);
-        }
-        if (b1.allShipsDestroyed())
+        if (takeTurn(p2, p1, b2, b1, ++turns))
         {
             break;
         }
-        if (shouldPause)
-        {
-            waitForEnter();
-        }
     }
-    //if the losing player is human, display the winner's board, showing everything 
+    Player* winner = p1;
     if (b1.allShipsDestroyed())
-    {
-        if (p1->isHuman())
-            b2.display(false);
-        return p2; 
-    }
-    if (b2.allShipsDestroyed())
-    {
-        if (p2->isHuman())
-            b1.display(false);
-        return p1;
-    }
-    return p1; 
+        winner = p2;
+    Player* loser = (winner == p1 ? p2 : p1);
+    for (size_t k = 0; k < observers.size(); k++)
+        observers[k]->gameOver(*winner, *loser, winner == p1 ? b1 : b2, winner == p1 ? b2 : b1, turns);
+    return winner; 
 }
 
 //******************** Game functions *******************************
@@ -347,6 +369,11 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
 // You probably don't want to change any of the code from this point down.
 
 Game::Game(int nRows, int nCols)
+    : Game(nRows, nCols, randomSeed())
+{
+}
+
+Game::Game(int nRows, int nCols, unsigned long long seed)
 {
     if (nRows < 1 || nRows > MAXROWS)
     {
@@ -358,7 +385,7 @@ Game::Game(int nRows, int nCols)
         cout << "Number of columns must be >= 1 and <= " << MAXCOLS << endl;
         exit(1);
     }
-    m_impl = new GameImpl(nRows, nCols);
+    m_impl = new GameImpl(nRows, nCols, seed);
 }
 
 Game::~Game()
@@ -386,6 +413,36 @@ Point Game::randomPoint() const
     return m_impl->randomPoint();
 }
 
+int Game::randInt(int limit) const
+{
+    return m_impl->randInt(limit);
+}
+
+unsigned long long Game::seed() const
+{
+    return m_impl->seed();
+}
+
+void Game::reseed(unsigned long long seed)
+{
+    m_impl->reseed(seed);
+}
+
+unsigned long long Game::nextSeed() const
+{
+    return m_impl->nextSeed();
+}
+
+void Game::setSalvo(int shots)
+{
+    m_impl->setSalvo(shots);
+}
+
+int Game::salvo() const
+{
+    return m_impl->salvo();
+}
+
 bool Game::addShip(int length, char symbol, string name)
 {
     if (length < 1)
@@ -447,18 +504,39 @@ char Game::shipSymbol(int shipId) const
     return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string& Game::shipName(int shipId) const
 {
     assert(shipId >= 0 && shipId < nShips());
     return m_impl->shipName(shipId);
 }
 
+void Game::reportAttack(Player* attacker, Point p, bool validShot, bool shotHit,
+    bool shipDestroyed, int shipId)
+{
+    m_impl->reportAttack(attacker, p, validShot, shotHit, shipDestroyed, shipId);
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
+{
+    return play(p1, p2, &cout, shouldPause);
+}
+
+Player* Game::play(Player* p1, Player* p2, ostream* out, bool shouldPause)
 {
     if (p1 == nullptr || p2 == nullptr || nShips() == 0)
         return nullptr;
-    Board b1(*this);
-    Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    Board& b1 = m_impl->board(0, *this);
+    Board& b2 = m_impl->board(1, *this);
+    return m_impl->play(p1, p2, b1, b2, out, shouldPause);
+}
+
+void Game::addObserver(GameObserver* o)
+{
+    m_impl->addObserver(o);
+}
+
+void Game::removeObserver(GameObserver* o)
+{
+    m_impl->removeObserver(o);
 }
 
@@ -2,27 +2,61 @@
 #define GAME_INCLUDED
 
 #include <string>
+#include <iosfwd>
 #include <cassert>
 
 class Point;
 class Player;
 class GameImpl;
+class GameObserver;
 
 class Game
 {
 public:
     Game(int nRows, int nCols);
+    // A game with an explicit seed replays exactly given the same players
+    Game(int nRows, int nCols, unsigned long long seed);
     ~Game();
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+    int randInt(int limit) const;
+    unsigned long long seed() const;
+    // Start the game's random numbers and player seeds over as if it had
+    // been constructed with seed, keeping its ships, so that one Game (and
+    // its players, once reset) can be replayed for many seeds
+    void reseed(unsigned long long seed);
+    // Seeds handed out in sequence to the players created for this game
+    unsigned long long nextSeed() const;
+    // Salvo rules: every turn fires shots shots together, or with
+    // ONE_PER_SHIP one for each ship the attacker has afloat, and no more
+    // than the cells the attacker has yet to try.  1, the default, is the
+    // classic game.
+    enum { ONE_PER_SHIP = 0 };
+    void setSalvo(int shots);
+    int salvo() const;
     bool addShip(int length, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    std::string shipName(int shipId) const;
+    const std::string& shipName(int shipId) const;
+    // The game keeps the two boards it plays on and resets them for each
+    // later game rather than making new ones
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    // Play with all reporting sent to out; a null out plays silently, with
+    // no message formatting or board rendering at all
+    Player* play(Player* p1, Player* p2, std::ostream* out, bool shouldPause = false);
+    // Tell attacker the result of its attack at p, as play does after every
+    // shot: the attacker's knowledge board is updated and then, unless the
+    // attacker is human, its recordAttackResult is called.  For driving
+    // players without play.
+    void reportAttack(Player* attacker, Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    // Observers receive every event of the games played afterwards; the
+    // Game does not own them
+    void addObserver(GameObserver* o);
+    void removeObserver(GameObserver* o);
     // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
@@ -0,0 +1,93 @@
+#include "GameObserver.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include <iostream>
+
+using namespace std;
+
+ConsoleObserver::ConsoleObserver(ostream& out, bool shouldPause, bool inPlace)
+    : m_out(out), m_shouldPause(shouldPause), m_inPlace(inPlace), m_pauseBeforeNextTurn(false),
+      m_salvoBoard(nullptr), m_salvoShotsOnly(false)
+{}
+
+void ConsoleObserver::shipPlaced(const Player& /* owner */, const Board& b,
+    int /* shipId */, Point /* topOrLeft */, Direction /* dir */)
+{
+    //while the game is still being set up
+    b.prepareDisplay();
+}
+
+void ConsoleObserver::turnStarted(const Player& attacker, const Player& defender,
+    const Board& b)
+{
+    //pause between turns, but not before the first one
+    if (m_pauseBeforeNextTurn)
+    {
+        m_out << "Press enter to continue: " << flush;
+        cin.ignore(10000, '\n');
+    }
+    m_pauseBeforeNextTurn = m_shouldPause;
+    //written piece by piece, with no strings built, so that commentary
+    //does not allocate
+    m_out << attacker.name() << "'s turn. Board for " << defender.name() << ":\n";
+    //a human only gets to see the shots on the opponent's board
+    b.display(attacker.isHuman(), m_out);
+}
+
+void ConsoleObserver::shotFired(const Player& attacker, const Player& /* defender */,
+    const Board& b, Point p, bool validShot, bool shotHit, bool shipDestroyed,
+    int shipId)
+{
+    //a human's prompt and answer come between, so only a computer's board
+    //is still right above the cursor from turnStarted
+    bool inPlace = m_inPlace && !attacker.isHuman();
+    //a salvo's shots are all resolved before the first is reported, so
+    //its board is final from the first shot on and is shown just once:
+    //in place now, or else below the last shot when the turn ends
+    bool salvo = (attacker.game().salvo() != 1);
+    if (inPlace && !(salvo && m_salvoBoard != nullptr))
+        b.redisplay(attacker.isHuman(), m_out);
+    if (salvo)
+    {
+        m_salvoBoard = &b;
+        m_salvoShotsOnly = attacker.isHuman();
+    }
+    m_out << attacker.name();
+    if (!validShot)
+        m_out << " wasted a shot at (" << p.r << "," << p.c << ")";
+    else
+    {
+        m_out << " attacked (" << p.r << "," << p.c << ") and ";
+        if (shotHit && shipDestroyed)
+            m_out << "destroyed the " << attacker.game().shipName(shipId);
+        else if (shotHit)
+            m_out << "hit something";
+        else
+            m_out << "missed";
+    }
+    m_out << (validShot && !inPlace && !salvo ? ", resulting in:\n" : ".\n");
+    if (!inPlace && !salvo)
+        b.display(attacker.isHuman(), m_out);
+}
+
+void ConsoleObserver::turnEnded(const Player& attacker, int /* turnNumber */)
+{
+    if (m_salvoBoard == nullptr)
+        return;
+    if (!(m_inPlace && !attacker.isHuman()))
+    {
+        m_out << "Resulting in:\n";
+        m_salvoBoard->display(m_salvoShotsOnly, m_out);
+    }
+    m_salvoBoard = nullptr;
+}
+
+void ConsoleObserver::gameOver(const Player& /* winner */, const Player& loser,
+    const Board& winnerBoard, const Board& /* loserBoard */, int /* turns */)
+{
+    //if the losing player is human, display the winner's board, showing everything 
+    if (loser.isHuman())
+        winnerBoard.display(false, m_out);
+    m_pauseBeforeNextTurn = false;
+}
@@ -0,0 +1,68 @@
+#ifndef GAMEOBSERVER_INCLUDED
+#define GAMEOBSERVER_INCLUDED
+
+#include "globals.h"
+#include <iosfwd>
+
+class Board;
+class Player;
+
+// Receives the events of a Game::play as they happen.  Every handler does
+// nothing by default, so an observer overrides just the events it wants.
+// Games with no observers attached skip event delivery entirely.
+class GameObserver
+{
+public:
+    virtual ~GameObserver() {}
+
+    // owner has put shipId on its board b
+    virtual void shipPlaced(const Player& /* owner */, const Board& /* b */,
+        int /* shipId */, Point /* topOrLeft */, Direction /* dir */) {}
+    // attacker is about to choose a shot at defender's board b
+    virtual void turnStarted(const Player& /* attacker */,
+        const Player& /* defender */, const Board& /* b */) {}
+    // attacker fired at p on defender's board b; shipId is meaningful only
+    // if shipDestroyed
+    virtual void shotFired(const Player& /* attacker */,
+        const Player& /* defender */, const Board& /* b */, Point /* p */,
+        bool /* validShot */, bool /* shotHit */, bool /* shipDestroyed */,
+        int /* shipId */) {}
+    // attacker's turn, the turnNumber'th of the game counting from 1, is over
+    virtual void turnEnded(const Player& /* attacker */, int /* turnNumber */) {}
+    // winner sank all of loser's ships; loserBoard and winnerBoard are the
+    // boards that belonged to each of them
+    virtual void gameOver(const Player& /* winner */, const Player& /* loser */,
+        const Board& /* winnerBoard */, const Board& /* loserBoard */,
+        int /* turns */) {}
+};
+
+// Writes the classic text commentary for a game, optionally waiting for
+// the enter key between turns.  With inPlace, meant for a terminal, the
+// board shown at the start of a turn is updated in place after the shot
+// (see Board::redisplay) instead of being drawn again below the result.
+// Under salvo rules the board is shown once per salvo, after all its shots
+// are listed, or updated in place before them.
+class ConsoleObserver : public GameObserver
+{
+public:
+    ConsoleObserver(std::ostream& out, bool shouldPause, bool inPlace = false);
+    virtual void shipPlaced(const Player& owner, const Board& b, int shipId,
+        Point topOrLeft, Direction dir);
+    virtual void turnStarted(const Player& attacker, const Player& defender,
+        const Board& b);
+    virtual void shotFired(const Player& attacker, const Player& defender,
+        const Board& b, Point p, bool validShot, bool shotHit,
+        bool shipDestroyed, int shipId);
+    virtual void turnEnded(const Player& attacker, int turnNumber);
+    virtual void gameOver(const Player& winner, const Player& loser,
+        const Board& winnerBoard, const Board& loserBoard, int turns);
+private:
+    std::ostream& m_out;
+    bool m_shouldPause;
+    bool m_inPlace;
+    bool m_pauseBeforeNextTurn;
+    const Board* m_salvoBoard;      // under salvo rules, the board this turn fired at
+    bool m_salvoShotsOnly;
+};
+
+#endif // GAMEOBSERVER_INCLUDED
@@ -0,0 +1,47 @@
+#include "KnowledgeBoard.h"
+#include "Game.h"
+#include <vector>
+
+using namespace std;
+
+KnowledgeBoard::KnowledgeBoard(const Game& g)
+    : m_game(g), m_cols(g.cols()), m_cells(g.rows() * g.cols())
+{
+    clear();
+}
+
+void KnowledgeBoard::clear()
+{
+    int words = (m_cells + 63) / 64;
+    m_tried.assign(words, 0);
+    m_hit.assign(words, 0);
+    m_sank.assign(words, 0);
+    //ships may have been added to the game since the last clear
+    m_sunk.assign(m_game.nShips(), 0);
+    m_nTried = 0;
+    m_nHits = 0;
+    m_nShipsSunk = 0;
+}
+
+void KnowledgeBoard::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!m_game.isValid(p) || isTried(p))
+        return;
+    int cell = index(p);
+    set(m_tried, cell);
+    m_nTried++;
+    if (!shotHit)
+        return;
+    set(m_hit, cell);
+    m_nHits++;
+    if (!shipDestroyed)
+        return;
+    set(m_sank, cell);
+    if (shipId >= static_cast<int>(m_sunk.size()))
+        m_sunk.resize(shipId + 1, 0);
+    if (shipId >= 0 && !m_sunk[shipId])
+    {
+        m_sunk[shipId] = 1;
+        m_nShipsSunk++;
+    }
+}
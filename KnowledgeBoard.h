@@ -0,0 +1,68 @@
+#ifndef KNOWLEDGEBOARD_INCLUDED
+#define KNOWLEDGEBOARD_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <vector>
+
+class Game;
+class GameImpl;
+
+// What a player has been told about its opponent's board: which cells it
+// hit and missed, where each of its sinking shots landed, and which ships
+// it has sunk.  The Game keeps one for every player and updates it before
+// passing each result on to recordAttackResult, so a player can look any
+// of this up in O(1) instead of keeping its own record.  A player only
+// ever gets to read it.
+//
+// Cells are kept as bitmasks in row-major order, 64 cells to a word.
+class KnowledgeBoard
+{
+public:
+    KnowledgeBoard(const Game& g);
+
+    bool isTried(Point p) const { return test(m_tried, index(p)); }
+    bool isHit(Point p) const { return test(m_hit, index(p)); }
+    bool isMiss(Point p) const { return isTried(p) && !isHit(p); }
+    // Did the shot at p sink a ship?
+    bool sankShip(Point p) const { return test(m_sank, index(p)); }
+    bool shipSunk(int shipId) const
+        { return shipId >= 0 && shipId < static_cast<int>(m_sunk.size()) && m_sunk[shipId]; }
+    int nTried() const { return m_nTried; }
+    int nHits() const { return m_nHits; }
+    int nShipsSunk() const { return m_nShipsSunk; }
+    // Every cell has been tried
+    bool allTried() const { return m_nTried == m_cells; }
+
+    // The masks themselves, bit cell % 64 of word cell / 64
+    const std::vector<std::uint64_t>& triedMask() const { return m_tried; }
+    const std::vector<std::uint64_t>& hitMask() const { return m_hit; }
+    const std::vector<std::uint64_t>& sankMask() const { return m_sank; }
+
+private:
+    friend class GameImpl;
+
+    const Game& m_game;
+    int m_cols;
+    int m_cells;
+    std::vector<std::uint64_t> m_tried;
+    std::vector<std::uint64_t> m_hit;
+    std::vector<std::uint64_t> m_sank;
+    std::vector<char> m_sunk;               // per ship
+    int m_nTried;
+    int m_nHits;
+    int m_nShipsSunk;
+
+    int index(Point p) const { return p.r * m_cols + p.c; }
+    static bool test(const std::vector<std::uint64_t>& mask, int cell)
+        { return (mask[cell >> 6] >> (cell & 63)) & 1; }
+    static void set(std::vector<std::uint64_t>& mask, int cell)
+        { mask[cell >> 6] |= std::uint64_t(1) << (cell & 63); }
+
+    // Forget everything, for a new game
+    void clear();
+    // Record the result of a valid attack at p
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+};
+
+#endif // KNOWLEDGEBOARD_INCLUDED
@@ -0,0 +1,360 @@
+#include "LayoutSampler.h"
+#include "Game.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // limitThreads's cap for the calling thread, or 0
+    thread_local int threadLimit = 0;
+}
+
+// Helper threads kept waiting between sample() calls.  run hands every
+// thread, the caller included, one call of a job and returns once all of
+// them have finished.
+class LayoutSampler::Pool
+{
+public:
+    Pool(int nThreads);
+    ~Pool();
+    int size() const { return m_helpers.size() + 1; }
+    // Call job(t) for every t below size(), t == 0 on this thread
+    void run(const function<void(int)>& job);
+
+private:
+    vector<thread> m_helpers;
+    mutex m_mutex;
+    condition_variable m_wake;          // a job is posted, or the pool is closing
+    condition_variable m_finished;      // the last helper is done with a job
+    const function<void(int)>* m_job;
+    unsigned long long m_generation;    // jobs posted so far
+    int m_busy;                         // helpers still on the current job
+    bool m_closing;
+
+    void serve(int t);
+};
+
+LayoutSampler::Pool::Pool(int nThreads)
+    : m_job(nullptr), m_generation(0), m_busy(0), m_closing(false)
+{
+    for (int t = 1; t < nThreads; t++)
+        m_helpers.push_back(thread(&Pool::serve, this, t));
+}
+
+LayoutSampler::Pool::~Pool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_wake.notify_all();
+    for (size_t t = 0; t < m_helpers.size(); t++)
+        m_helpers[t].join();
+}
+
+void LayoutSampler::Pool::run(const function<void(int)>& job)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_job = &job;
+        m_busy = m_helpers.size();
+        m_generation++;
+    }
+    m_wake.notify_all();
+    job(0);
+    unique_lock<mutex> lock(m_mutex);
+    m_finished.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+}
+
+void LayoutSampler::Pool::serve(int t)
+{
+    unsigned long long seen = 0;
+    for (;;)
+    {
+        const function<void(int)>* job;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_closing || m_generation != seen; });
+            if (m_closing)
+                return;
+            seen = m_generation;
+            job = m_job;
+        }
+        (*job)(t);
+        lock_guard<mutex> lock(m_mutex);
+        if (--m_busy == 0)
+            m_finished.notify_one();
+    }
+}
+
+LayoutSampler::PoolHolder::~PoolHolder()
+{
+    delete pool;
+}
+
+int LayoutSampler::limitThreads(int n)
+{
+    int old = threadLimit;
+    threadLimit = (n > 0 ? n : 0);
+    return old;
+}
+
+LayoutSampler::LayoutSampler(const Game& g)
+    : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+      m_state(g.rows() * g.cols(), UNKNOWN),
+      m_hitOrder(g.rows() * g.cols(), -1),
+      m_sunkAt(g.nShips(), -1)
+{
+    for (int s = 0; s < g.nShips(); s++)
+        m_lengths.push_back(g.shipLength(s));
+}
+
+void LayoutSampler::reset()
+{
+    fill(m_state.begin(), m_state.end(), static_cast<unsigned char>(UNKNOWN));
+    fill(m_hitOrder.begin(), m_hitOrder.end(), -1);
+    fill(m_sunkAt.begin(), m_sunkAt.end(), -1);
+    m_hits.clear();
+}
+
+void LayoutSampler::record(Point p, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (!m_game.isValid(p) || m_state[index(p)] != UNKNOWN)
+        return;
+    int cell = index(p);
+    if (!shotHit)
+    {
+        m_state[cell] = MISS;
+        return;
+    }
+    m_state[cell] = HIT;
+    m_hitOrder[cell] = m_hits.size();
+    m_hits.push_back(cell);
+    if (shipDestroyed && shipId >= 0 && shipId < static_cast<int>(m_sunkAt.size()))
+        m_sunkAt[shipId] = cell;
+}
+
+bool LayoutSampler::legal(int shipId, Placement p) const
+{
+    int len = m_lengths[shipId];
+    int sunkAt = m_sunkAt[shipId];
+    bool allHit = true;
+    bool coversSink = false;
+    for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+    {
+        if (m_state[cell] == MISS)
+            return false;
+        if (m_state[cell] != HIT)
+            allHit = false;
+        else if (sunkAt >= 0 && m_hitOrder[cell] > m_hitOrder[sunkAt])
+            return false;
+        if (cell == sunkAt)
+            coversSink = true;
+    }
+    //a ship afloat still has an unhit cell; a sunk one was hit everywhere
+    //by the shot that sank it
+    if (sunkAt < 0)
+        return !allHit;
+    return allHit && coversSink;
+}
+
+void LayoutSampler::makePlan(Plan& plan) const
+{
+    //clear the lists rather than replace them so their storage is reused
+    int nShips = m_lengths.size();
+    plan.placements.resize(nShips);
+    plan.logPlacements.resize(nShips);
+    if (plan.covering.size() < m_hits.size())
+        plan.covering.resize(m_hits.size());
+    plan.logCovering.resize(plan.covering.size());
+    for (size_t j = 0; j < m_hits.size(); j++)
+        plan.covering[j].clear();
+    for (int s = 0; s < nShips; s++)
+    {
+        int len = m_lengths[s];
+        vector<Placement>& placements = plan.placements[s];
+        placements.clear();
+        forEachPlacement(m_rows, m_cols, len, [&](Placement p)
+        {
+            if (legal(s, p))
+                placements.push_back(p);
+            return true;
+        });
+        plan.logPlacements[s] = log(static_cast<double>(placements.size()));
+        if (m_sunkAt[s] >= 0)
+            continue;
+        //which hits each placement of a ship afloat could account for
+        for (size_t k = 0; k < placements.size(); k++)
+        {
+            Placement p = placements[k];
+            for (int j = 0, cell = p.start; j < len; j++, cell += p.step)
+            {
+                if (m_state[cell] == HIT)
+                    plan.covering[m_hitOrder[cell]].push_back(Option(s, p));
+            }
+        }
+    }
+    for (size_t j = 0; j < m_hits.size(); j++)
+        plan.logCovering[j] = log(static_cast<double>(plan.covering[j].size()));
+}
+
+double LayoutSampler::draw(const Plan& plan, Rng& rng, vector<int>& owner, Placement* placed) const
+{
+    int nShips = m_lengths.size();
+    for (int s = 0; s < nShips; s++)
+        placed[s] = Placement();
+    // Lay ship shipId at p unless a ship is already on one of its cells
+    auto put = [&](int shipId, Placement p)
+    {
+        int len = m_lengths[shipId];
+        for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+        {
+            if (owner[cell] >= 0)
+                return false;
+        }
+        for (int k = 0, cell = p.start; k < len; k++, cell += p.step)
+            owner[cell] = shipId;
+        placed[shipId] = p;
+        return true;
+    };
+
+    //the weight is the product of the numbers of choices, kept as its log
+    double logWeight = 0;
+    bool kept = true;
+    for (int s = 0; kept && s < nShips; s++)
+    {
+        if (m_sunkAt[s] < 0)
+            continue;
+        const vector<Placement>& options = plan.placements[s];
+        kept = !options.empty() && put(s, options[rng.randInt(options.size())]);
+        logWeight += plan.logPlacements[s];
+    }
+    for (size_t j = 0; kept && j < m_hits.size(); j++)
+    {
+        if (owner[m_hits[j]] >= 0)
+            continue;
+        const vector<Option>& options = plan.covering[j];
+        if (options.empty())
+            kept = false;
+        else
+        {
+            const Option& o = options[rng.randInt(options.size())];
+            kept = placed[o.shipId].start < 0 && put(o.shipId, o.p);
+        }
+        logWeight += plan.logCovering[j];
+    }
+    for (int s = 0; kept && s < nShips; s++)
+    {
+        if (placed[s].start >= 0)
+            continue;
+        const vector<Placement>& options = plan.placements[s];
+        kept = !options.empty() && put(s, options[rng.randInt(options.size())]);
+        logWeight += plan.logPlacements[s];
+    }
+
+    //leave owner empty for the next attempt
+    for (int s = 0; s < nShips; s++)
+    {
+        Placement p = placed[s];
+        if (p.start < 0)
+            continue;
+        for (int k = 0, cell = p.start; k < m_lengths[s]; k++, cell += p.step)
+            owner[cell] = -1;
+    }
+    return kept ? logWeight : -numeric_limits<double>::infinity();
+}
+
+int LayoutSampler::sample(unsigned long long seed, int nSamples, double seconds,
+    int nThreads, vector<double>& counts) const
+{
+    counts.assign(m_state.size(), 0);
+    if (nSamples <= 0)
+        return 0;
+    // Attempts are handed out in chunks so threads rarely touch the counter
+    const int CHUNK = 32;
+    if (nThreads <= 0)
+        nThreads = thread::hardware_concurrency();
+    if (nThreads <= 0)
+        nThreads = 1;
+    if (threadLimit > 0 && nThreads > threadLimit)
+        nThreads = threadLimit;
+    if (nThreads > (nSamples + CHUNK - 1) / CHUNK)
+        nThreads = (nSamples + CHUNK - 1) / CHUNK;
+    //the pool is kept until a call wants a different number of threads
+    if (nThreads > 1 && (m_pool.pool == nullptr || m_pool.pool->size() != nThreads))
+    {
+        delete m_pool.pool;
+        m_pool.pool = new Pool(nThreads);
+    }
+
+    Scratch& scratch = m_scratch;
+    makePlan(scratch.plan);
+    int nShips = m_lengths.size();
+    const double REJECTED = -numeric_limits<double>::infinity();
+    scratch.logWeights.assign(nSamples, REJECTED);
+    if (scratch.layouts.size() < static_cast<size_t>(nSamples) * nShips)
+        scratch.layouts.resize(static_cast<size_t>(nSamples) * nShips, Placement());
+    if (scratch.owners.size() < static_cast<size_t>(nThreads))
+        scratch.owners.resize(nThreads);
+    for (int t = 0; t < nThreads; t++)
+        scratch.owners[t].resize(m_state.size(), -1);
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds));
+
+    //every attempt writes only its own slots, so threads share nothing but
+    //the counter
+    atomic<int> next(0);
+    auto run = [&](int t)
+    {
+        for (int first = next.fetch_add(CHUNK); first < nSamples; first = next.fetch_add(CHUNK))
+        {
+            if (seconds > 0 && chrono::steady_clock::now() >= deadline)
+                break;
+            int last = (first + CHUNK < nSamples ? first + CHUNK : nSamples);
+            for (int k = first; k < last; k++)
+            {
+                Rng rng(mixSeed(seed + k));
+                scratch.logWeights[k] = draw(scratch.plan, rng, scratch.owners[t],
+                    &scratch.layouts[static_cast<size_t>(k) * nShips]);
+            }
+        }
+    };
+    //a reference fits in a function without allocating
+    if (nThreads == 1)
+        run(0);
+    else
+        m_pool.pool->run(ref(run));
+
+    //add the layouts up in attempt order, weighed against the heaviest
+    double heaviest = REJECTED;
+    for (int k = 0; k < nSamples; k++)
+        heaviest = max(heaviest, scratch.logWeights[k]);
+    int drawn = 0;
+    for (int k = 0; k < nSamples; k++)
+    {
+        if (scratch.logWeights[k] == REJECTED)
+            continue;
+        drawn++;
+        double weight = exp(scratch.logWeights[k] - heaviest);
+        const Placement* placed = &scratch.layouts[static_cast<size_t>(k) * nShips];
+        for (int s = 0; s < nShips; s++)
+        {
+            if (m_sunkAt[s] >= 0)
+                continue;
+            for (int j = 0, cell = placed[s].start; j < m_lengths[s]; j++, cell += placed[s].step)
+                counts[cell] += weight;
+        }
+    }
+    return drawn;
+}
@@ -0,0 +1,114 @@
+#ifndef LAYOUTSAMPLER_INCLUDED
+#define LAYOUTSAMPLER_INCLUDED
+
+#include "globals.h"
+#include "ShipPlacement.h"
+#include <vector>
+
+class Game;
+
+// Draws random fleet layouts of the opponent's board that agree with the
+// shots fired at it so far: no ship lies on a miss, every hit is covered,
+// a ship that is still afloat is not hit everywhere, and a sunk ship lies
+// entirely on cells hit no later than the shot that sank it.
+//
+// Each attempt lays down the sunk ships, then for every hit not yet
+// covered a ship afloat over it, then the remaining ships, each at a
+// placement drawn at random from every legal one (for a hit, from every
+// legal placement of a ship afloat that covers it), and is thrown away if
+// two ships overlap.  A layout can only be reached one way, with a chance
+// of 1 over the product of the numbers of choices along the way, so each
+// layout kept is counted with that product as its weight; the weighted
+// counts are then those of a uniform sample of the consistent layouts.
+// With no hits every weight is the same and this is plain rejection
+// sampling.
+//
+// The threads of a multi-threaded sample() are started by the first such
+// call and kept for the later ones; a copy of a sampler starts without
+// any.  One sampler must not sample on two threads at once.
+class LayoutSampler
+{
+public:
+    LayoutSampler(const Game& g);
+    // Record the result of attacking p, as passed to recordAttackResult
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId);
+    // Forget every result, as if newly constructed
+    void reset();
+    bool tried(Point p) const { return m_state[index(p)] != UNKNOWN; }
+
+    // Make up to nSamples attempts at a layout on nThreads threads (0 means
+    // one per hardware thread), stopping early once seconds have passed if
+    // seconds is positive.  counts[cell] is set to the total weight of the
+    // layouts that put a ship that is still afloat on cell, scaled so the
+    // heaviest layout weighs 1.  Attempt k uses its own generator seeded
+    // from seed and k, and the layouts are added up in attempt order, so
+    // unless the deadline cuts the run short the counts depend only on seed
+    // and nSamples, not on the number of threads.  Returns the number of
+    // layouts drawn.
+    int sample(unsigned long long seed, int nSamples, double seconds,
+        int nThreads, std::vector<double>& counts) const;
+    // Cap the threads of every sample() made on the calling thread at n (0
+    // for no cap), for callers that are already one of many threads.
+    // Returns the cap it replaces.
+    static int limitThreads(int n);
+
+private:
+    enum CellState { UNKNOWN, MISS, HIT };
+
+    // Placement p of ship shipId
+    struct Option
+    {
+        Option(int s, Placement pl) : shipId(s), p(pl) {}
+        int shipId;
+        Placement p;
+    };
+    // What every attempt of one sample() call shares.  The lists are kept
+    // from call to call so their storage is reused.
+    struct Plan
+    {
+        std::vector<std::vector<Placement> > placements;   // per ship
+        std::vector<double> logPlacements;                  // per ship, log of the count
+        std::vector<std::vector<Option> > covering;         // per hit, by m_hits index
+        std::vector<double> logCovering;                    // per hit, log of the count
+    };
+    // What sample() reuses from one call to the next, which copying does
+    // not share or copy
+    struct Scratch
+    {
+        Scratch() {}
+        Scratch(const Scratch&) {}
+        Scratch& operator=(const Scratch&) { return *this; }
+        Plan plan;
+        std::vector<double> logWeights;         // per attempt, -infinity if thrown away
+        std::vector<Placement> layouts;         // per attempt, every ship's placement
+        std::vector<std::vector<int> > owners;  // per thread, the ship on each cell or -1
+    };
+    class Pool;
+    // The sampler's pool, which copying does not share or copy
+    struct PoolHolder
+    {
+        PoolHolder() : pool(nullptr) {}
+        PoolHolder(const PoolHolder&) : pool(nullptr) {}
+        PoolHolder& operator=(const PoolHolder&) { return *this; }
+        ~PoolHolder();
+        Pool* pool;
+    };
+
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    std::vector<int> m_lengths;             // per ship
+    std::vector<unsigned char> m_state;     // CellState per cell, row-major
+    std::vector<int> m_hitOrder;            // per cell, when it was hit
+    std::vector<int> m_hits;                // hit cells in the order hit
+    std::vector<int> m_sunkAt;              // per ship, the cell that sank it, or -1
+    mutable PoolHolder m_pool;              // started by the first multi-threaded sample()
+    mutable Scratch m_scratch;
+
+    int index(Point p) const { return p.r * m_cols + p.c; }
+    void makePlan(Plan& plan) const;
+    bool legal(int shipId, Placement p) const;
+    double draw(const Plan& plan, Rng& rng, std::vector<int>& owner, Placement* placed) const;
+};
+
+#endif // LAYOUTSAMPLER_INCLUDED
@@ -0,0 +1,670 @@
+#include "LockstepEngine.h"
+#include "Board.h"
+#include "FleetPlacer.h"
+#include "Game.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// LockstepImpl is the interface LockstepEngine delegates to.  There is a
+// LockstepLanes for each supported board size and lane count, so that
+// every loop over cells, words or lanes has a compile-time trip count.
+class LockstepImpl
+{
+public:
+    LockstepImpl(const Game& g, LockstepEngine::Strategy s1, LockstepEngine::Strategy s2);
+    virtual ~LockstepImpl() {}
+    virtual int lanes() const = 0;
+    virtual void run(LockstepSchedule& schedule) = 0;
+
+protected:
+    const Game& m_game;
+    LockstepEngine::Strategy m_strategy[2];     // of player 1 and player 2
+    Board m_board;              // where each fleet is laid out before it is loaded
+    FleetPlacer m_placer;
+    vector<int> m_shipLengths;  // per ship
+    vector<int> m_lengths;      // distinct ship lengths, ascending
+    vector<int> m_fleet;        // ships of each of those lengths
+    vector<int> m_lengthIndex;  // per ship, its length's index in m_lengths
+
+    // Lay out on m_board the fleet of a player of strategy s created with
+    // seed, just as that player would.  Returns false if it could not.
+    bool layOut(LockstepEngine::Strategy s, unsigned long long seed);
+};
+
+LockstepImpl::LockstepImpl(const Game& g, LockstepEngine::Strategy s1, LockstepEngine::Strategy s2)
+    : m_game(g), m_board(g), m_placer(g), m_lengthIndex(g.nShips())
+{
+    m_strategy[0] = s1;
+    m_strategy[1] = s2;
+    for (int s = 0; s < g.nShips(); s++)
+        m_shipLengths.push_back(g.shipLength(s));
+    m_lengths = m_shipLengths;
+    sort(m_lengths.begin(), m_lengths.end());
+    m_lengths.erase(unique(m_lengths.begin(), m_lengths.end()), m_lengths.end());
+    m_fleet.assign(m_lengths.size(), 0);
+    for (int s = 0; s < g.nShips(); s++)
+    {
+        m_lengthIndex[s] = lower_bound(m_lengths.begin(), m_lengths.end(),
+            g.shipLength(s)) - m_lengths.begin();
+        m_fleet[m_lengthIndex[s]]++;
+    }
+}
+
+bool LockstepImpl::layOut(LockstepEngine::Strategy s, unsigned long long seed)
+{
+    m_board.reset();
+    if (s == LockstepEngine::AWFUL)
+    {
+        //as AwfulPlayer::placeShips
+        for (size_t k = 0; k < m_shipLengths.size(); k++)
+            if (!m_board.placeShip(Point(k, 0), k, HORIZONTAL))
+                return false;
+        return true;
+    }
+    //as GoodPlayer::placeShips, with the player's generator as created
+    Rng rng(seed);
+    return m_placer.placeShips(m_board, rng);
+}
+
+//*********************************************************************
+//  Lane operations
+//*********************************************************************
+
+// Everything from here to the LockstepEngine functions is private to this
+// file; PlacementKernel.cpp has Ops types of the same names for int32
+namespace
+{
+
+// Each Ops type exposes the lane-wise int16 operations the density kernel
+// needs, LANES games at a time.  The densities of the supported fleets
+// fit in 16 bits, so a vector holds twice as many games as it would
+// with 32-bit sums.
+
+struct ScalarOps
+{
+    typedef int16_t V;
+    enum { LANES = 1 };
+    static V load(const int16_t* p) { return *p; }
+    static void store(int16_t* p, V v) { *p = v; }
+    static V set1(int x) { return static_cast<V>(x); }
+    static V add(V a, V b) { return static_cast<V>(a + b); }
+    static V sub(V a, V b) { return static_cast<V>(a - b); }
+    static V mul(V a, V b) { return static_cast<V>(a * b); }
+    static V band(V a, V b) { return static_cast<V>(a & b); }
+    static V bor(V a, V b) { return static_cast<V>(a | b); }
+    static V andnot(V a, V b) { return static_cast<V>(~a & b); }
+    static V cmpgt(V a, V b) { return static_cast<V>(a > b ? -1 : 0); }
+    static V max(V a, V b) { return (a > b ? a : b); }
+    static bool allNegative(V a) { return a < 0; }
+};
+
+#if defined(__SSE2__)
+struct Sse2Ops
+{
+    typedef __m128i V;
+    enum { LANES = 8 };
+    static V load(const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int16_t* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V set1(int x) { return _mm_set1_epi16(static_cast<short>(x)); }
+    static V add(V a, V b) { return _mm_add_epi16(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi16(a, b); }
+    static V mul(V a, V b) { return _mm_mullo_epi16(a, b); }
+    static V band(V a, V b) { return _mm_and_si128(a, b); }
+    static V bor(V a, V b) { return _mm_or_si128(a, b); }
+    static V andnot(V a, V b) { return _mm_andnot_si128(a, b); }
+    static V cmpgt(V a, V b) { return _mm_cmpgt_epi16(a, b); }
+    static V max(V a, V b) { return _mm_max_epi16(a, b); }
+    static bool allNegative(V a) { return (_mm_movemask_epi8(a) & 0xAAAA) == 0xAAAA; }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2Ops
+{
+    typedef __m256i V;
+    enum { LANES = 16 };
+    static V load(const int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int16_t* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V set1(int x) { return _mm256_set1_epi16(static_cast<short>(x)); }
+    static V add(V a, V b) { return _mm256_add_epi16(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi16(a, b); }
+    static V mul(V a, V b) { return _mm256_mullo_epi16(a, b); }
+    static V band(V a, V b) { return _mm256_and_si256(a, b); }
+    static V bor(V a, V b) { return _mm256_or_si256(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_si256(a, b); }
+    static V cmpgt(V a, V b) { return _mm256_cmpgt_epi16(a, b); }
+    static V max(V a, V b) { return _mm256_max_epi16(a, b); }
+    static bool allNegative(V a)
+        { return (static_cast<unsigned>(_mm256_movemask_epi8(a)) & 0xAAAAAAAAu) == 0xAAAAAAAAu; }
+};
+#endif
+
+// The widest Ops compiled in whose vectors fit in Lanes games
+template<int Lanes, bool Wide = (Lanes >= 16)>
+struct LaneOps
+{
+#if defined(__SSE2__)
+    typedef Sse2Ops Type;
+#else
+    typedef ScalarOps Type;
+#endif
+};
+
+template<int Lanes>
+struct LaneOps<Lanes, true>
+{
+#if defined(__AVX2__)
+    typedef Avx2Ops Type;
+#elif defined(__SSE2__)
+    typedef Sse2Ops Type;
+#else
+    typedef ScalarOps Type;
+#endif
+};
+
+//*********************************************************************
+//  LockstepLanes
+//*********************************************************************
+
+// Lanes games on a Rows x Cols board.  Everything is stored as arrays
+// indexed by lane last, so one cell or word of every game is a run of
+// consecutive memory.
+template<int Rows, int Cols, int Lanes>
+class LockstepLanes : public LockstepImpl
+{
+public:
+    LockstepLanes(const Game& g, LockstepEngine::Strategy s1, LockstepEngine::Strategy s2);
+    virtual int lanes() const { return Lanes; }
+    virtual void run(LockstepSchedule& schedule);
+
+private:
+    static const int CELLS = Rows * Cols;
+    static const int WORDS = (CELLS + 63) / 64;
+    // No ship is longer than the board's longer side
+    static const int MAXLENGTHS = (Rows > Cols ? Rows : Cols);
+    // DensityMap's extra weight for each unsunk hit a placement covers, and
+    // what a cell no placement may cover adds to a placement's weight: it
+    // leaves the weight negative however many hits the placement covers,
+    // and a whole line of such cells still fits in 16 bits
+    enum { HIT_BONUS = 64, BLOCKED = -1024 };
+    static_assert(1 + HIT_BONUS * (MAXLENGTHS - 1) + BLOCKED < 0 &&
+        MAXLENGTHS * BLOCKED >= -32768, "BLOCKED does not suit the board");
+    enum CellState { MISS, HIT, SUNK };
+    typedef typename LaneOps<Lanes>::Type Ops;
+    typedef typename Ops::V V;
+
+    // A bitboard per lane, bit cell % 64 of word cell / 64
+    struct Bits
+    {
+        uint64_t w[WORDS][Lanes];
+    };
+
+    // One player in every lane: its own fleet and the shots fired at it,
+    // and what it has learned about the other player's fleet
+    struct Side
+    {
+        vector<Bits> ships;         // per shipId
+        Bits occupied;              // union of the ships
+        Bits hits;
+        Bits misses;
+        signed char owner[CELLS][Lanes];    // shipId on each cell, or -1
+        int fleetSunk[Lanes];
+        // The density strategy's view of the other board, as DensityMap
+        // keeps it: -1 where a cell is untried; what the cell adds to the
+        // weight of a placement covering it (BLOCKED on a miss or a sunk
+        // ship, HIT_BONUS on an unsunk hit, otherwise 0); and the ships of
+        // each length left afloat
+        int16_t open[CELLS][Lanes];
+        int16_t value[CELLS][Lanes];
+        int16_t afloat[MAXLENGTHS][Lanes];
+        // The awful strategy's last shot
+        int cursor[Lanes];
+    };
+
+    Side m_side[2];             // player 1, player 2
+    int m_target[Lanes];        // the shots of the turn being played
+    int m_id[Lanes];            // game in each lane
+    int m_busy[Lanes];
+    int m_p1First[Lanes];
+    int m_turns[Lanes];         // each player's shots so far
+
+    // Start the next game of schedule in lane.  Returns false, leaving the
+    // lane idle, if there are none left.
+    bool startGame(int lane, LockstepSchedule& schedule);
+    // Copy m_board's fleet into lane of s
+    void loadFleet(Side& s, int lane);
+    void awfulTargets(Side& attacker);
+    void densityTargets(const Side& attacker);
+    void densityTargets(const Side& attacker, int lane);
+    // Fire m_target of every lane at defender's fleet, passing the results
+    // of valid shots on to the density strategy if recordResults
+    void attack(Side& attacker, Side& defender, bool recordResults);
+    // DensityMap::record and markSunk, for one lane
+    void record(Side& s, int lane, int cell, bool shotHit, int shipId);
+    void setState(Side& s, int lane, int cell, CellState state);
+    void markSunk(Side& s, int lane, int cell, int length);
+    // Every cell of mask is also in other, in lane
+    static bool subsetOf(const Bits& mask, const Bits& other, int lane)
+    {
+        uint64_t acc = 0;
+        for (int w = 0; w < WORDS; w++)
+            acc |= mask.w[w][lane] & ~other.w[w][lane];
+        return acc == 0;
+    }
+};
+
+template<int Rows, int Cols, int Lanes>
+LockstepLanes<Rows, Cols, Lanes>::LockstepLanes(const Game& g,
+        LockstepEngine::Strategy s1, LockstepEngine::Strategy s2)
+    : LockstepImpl(g, s1, s2)
+{
+    //lanes left idle still play, so everything starts out defined
+    for (int s = 0; s < 2; s++)
+    {
+        Side& side = m_side[s];
+        side.ships.resize(g.nShips());
+        for (size_t k = 0; k < side.ships.size(); k++)
+            memset(&side.ships[k], 0, sizeof(Bits));
+        memset(&side.occupied, 0, sizeof(Bits));
+        memset(&side.hits, 0, sizeof(Bits));
+        memset(&side.misses, 0, sizeof(Bits));
+        memset(side.owner, -1, sizeof(side.owner));
+        memset(side.fleetSunk, 0, sizeof(side.fleetSunk));
+        memset(side.open, 0, sizeof(side.open));
+        memset(side.value, 0, sizeof(side.value));
+        memset(side.afloat, 0, sizeof(side.afloat));
+        memset(side.cursor, 0, sizeof(side.cursor));
+    }
+    for (int l = 0; l < Lanes; l++)
+        m_busy[l] = 0;
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::run(LockstepSchedule& schedule)
+{
+    int busy = 0;
+    for (int l = 0; l < Lanes; l++)
+        busy += startGame(l, schedule);
+    while (busy > 0)
+    {
+        //idle lanes play on too; nothing they do is reported
+        for (int a = 0; a < 2; a++)
+        {
+            bool density = (m_strategy[a] == LockstepEngine::DENSITY);
+            if (density)
+                densityTargets(m_side[a]);
+            else
+                awfulTargets(m_side[a]);
+            attack(m_side[a], m_side[1 - a], density);
+        }
+        for (int l = 0; l < Lanes; l++)
+        {
+            if (!m_busy[l])
+                continue;
+            m_turns[l]++;
+            int first = (m_p1First[l] ? 0 : 1);
+            int winner;
+            long long shots[2] = { m_turns[l], m_turns[l] };
+            //the first mover's shot came first, so the second mover's shot
+            //of that turn was never fired
+            if (m_side[1 - first].fleetSunk[l])
+            {
+                winner = first;
+                shots[1 - first]--;
+            }
+            else if (m_side[first].fleetSunk[l])
+                winner = 1 - first;
+            else
+                continue;
+            schedule.gameOver(m_id[l], winner + 1, shots[0], shots[1]);
+            if (!startGame(l, schedule))
+                busy--;
+        }
+    }
+}
+
+template<int Rows, int Cols, int Lanes>
+bool LockstepLanes<Rows, Cols, Lanes>::startGame(int lane, LockstepSchedule& schedule)
+{
+    LockstepGame game;
+    m_busy[lane] = 0;
+    while (schedule.nextGame(game))
+    {
+        unsigned long long seed[2] = { game.seed1, game.seed2 };
+        //Game::play will not play without ships
+        bool placed = !m_shipLengths.empty();
+        for (int s = 0; s < 2 && placed; s++)
+        {
+            placed = layOut(m_strategy[s], seed[s]);
+            if (placed)
+                loadFleet(m_side[s], lane);
+        }
+        if (!placed)
+        {
+            schedule.gameOver(game.id, 0, 0, 0);
+            continue;
+        }
+        for (int s = 0; s < 2; s++)
+        {
+            Side& side = m_side[s];
+            side.fleetSunk[lane] = 0;
+            side.cursor[lane] = 0;
+            if (m_strategy[s] != LockstepEngine::DENSITY)
+                continue;
+            for (int cell = 0; cell < CELLS; cell++)
+            {
+                side.open[cell][lane] = -1;
+                side.value[cell][lane] = 0;
+            }
+            for (int i = 0; i < MAXLENGTHS; i++)
+                side.afloat[i][lane] = (i < static_cast<int>(m_fleet.size()) ? m_fleet[i] : 0);
+        }
+        m_id[lane] = game.id;
+        m_p1First[lane] = game.p1First;
+        m_turns[lane] = 0;
+        m_busy[lane] = 1;
+        return true;
+    }
+    return false;
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::loadFleet(Side& s, int lane)
+{
+    for (int w = 0; w < WORDS; w++)
+    {
+        s.occupied.w[w][lane] = 0;
+        s.hits.w[w][lane] = 0;
+        s.misses.w[w][lane] = 0;
+    }
+    //owner is only ever read where a ship is, so the last fleet's entries
+    //can stay
+    for (size_t k = 0; k < s.ships.size(); k++)
+    {
+        Bits& ship = s.ships[k];
+        for (int w = 0; w < WORDS; w++)
+            ship.w[w][lane] = 0;
+        Point topOrLeft;
+        Direction dir;
+        if (!m_board.shipPlacement(k, topOrLeft, dir))
+            continue;
+        int cell = topOrLeft.r * Cols + topOrLeft.c;
+        int step = (dir == HORIZONTAL ? 1 : Cols);
+        for (int j = 0; j < m_shipLengths[k]; j++, cell += step)
+        {
+            ship.w[cell >> 6][lane] |= uint64_t(1) << (cell & 63);
+            s.owner[cell][lane] = k;
+        }
+        for (int w = 0; w < WORDS; w++)
+            s.occupied.w[w][lane] |= ship.w[w][lane];
+    }
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::awfulTargets(Side& attacker)
+{
+    //the cell before the last one attacked, wrapping round to the last cell
+    for (int l = 0; l < Lanes; l++)
+    {
+        int last = attacker.cursor[l];
+        int next = (last == 0 ? CELLS - 1 : last - 1);
+        attacker.cursor[l] = next;
+        m_target[l] = next;
+    }
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::densityTargets(const Side& attacker)
+{
+    for (int l = 0; l < Lanes; l += Ops::LANES)
+        densityTargets(attacker, l);
+}
+
+// DensityMap::best, computed from scratch for the Ops::LANES games from
+// lane on, a row or column at a time.  Running sums of the cells' values
+// give the weight of each placement along the line in one subtraction;
+// each weight is then added where its placement enters the line and taken
+// off where it leaves, so that running sums of those give every cell's
+// density.
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::densityTargets(const Side& attacker, int lane)
+{
+    V zero = Ops::set1(0);
+    V one = Ops::set1(1);
+    //lengths with a ship left in some game of this block
+    int live[MAXLENGTHS];
+    int nLive = 0;
+    for (size_t i = 0; i < m_lengths.size(); i++)
+    {
+        if (!Ops::allNegative(Ops::sub(Ops::load(&attacker.afloat[i][lane]), one)))
+            live[nLive++] = i;
+    }
+    V density[CELLS];
+    for (int line = 0; line < Rows + Cols; line++)
+    {
+        //the rows, then the columns
+        bool across = (line < Rows);
+        int first = (across ? line * Cols : line - Rows);
+        int step = (across ? 1 : Cols);
+        int n = (across ? Cols : Rows);
+        V sums[MAXLENGTHS + 1];
+        V enter[MAXLENGTHS + 1];
+        sums[0] = zero;
+        for (int k = 0; k < n; k++)
+        {
+            sums[k + 1] = Ops::add(sums[k], Ops::load(&attacker.value[first + k * step][lane]));
+            enter[k] = zero;
+        }
+        enter[n] = zero;
+        for (int j = 0; j < nLive && m_lengths[live[j]] <= n; j++)
+        {
+            int length = m_lengths[live[j]];
+            V afloat = Ops::load(&attacker.afloat[live[j]][lane]);
+            for (int k = 0; k + length <= n; k++)
+            {
+                V weight = Ops::add(Ops::sub(sums[k + length], sums[k]), one);
+                V w = Ops::mul(Ops::max(weight, zero), afloat);
+                enter[k] = Ops::add(enter[k], w);
+                enter[k + length] = Ops::sub(enter[k + length], w);
+            }
+        }
+        V running = zero;
+        for (int k = 0; k < n; k++)
+        {
+            running = Ops::add(running, enter[k]);
+            int cell = first + k * step;
+            density[cell] = (across ? running : Ops::add(density[cell], running));
+        }
+    }
+    //the untried cell with the highest density, the lowest of equals, or
+    //cell 0 if none is left
+    V best = Ops::set1(-1);
+    V target = zero;
+    for (int cell = 0; cell < CELLS; cell++)
+    {
+        V open = Ops::load(&attacker.open[cell][lane]);
+        V d = Ops::bor(Ops::band(open, density[cell]), Ops::andnot(open, Ops::set1(-1)));
+        V better = Ops::cmpgt(d, best);
+        best = Ops::max(d, best);
+        target = Ops::bor(Ops::band(better, Ops::set1(cell)), Ops::andnot(better, target));
+    }
+    int16_t cells[Ops::LANES];
+    Ops::store(cells, target);
+    for (int l = 0; l < Ops::LANES; l++)
+        m_target[lane + l] = cells[l];
+}
+
+// Board::attack in every lane.  A shot is valid if it is on the board and
+// not at a cell attacked before; it hits if a ship is there, and destroys
+// that ship if it was the ship's last unhit cell.  With bitboards and the
+// owner of each cell at hand, that is a few word operations per game.
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::attack(Side& attacker, Side& defender, bool recordResults)
+{
+    for (int l = 0; l < Lanes; l++)
+    {
+        int t = m_target[l];
+        if (t < 0 || t >= CELLS)
+            continue;
+        int w = t >> 6;
+        uint64_t bit = uint64_t(1) << (t & 63);
+        if ((defender.hits.w[w][l] | defender.misses.w[w][l]) & bit)
+            continue;
+        bool shotHit = (defender.occupied.w[w][l] & bit) != 0;
+        int shipId = -1;
+        if (shotHit)
+        {
+            defender.hits.w[w][l] |= bit;
+            int k = defender.owner[t][l];
+            if (subsetOf(defender.ships[k], defender.hits, l))
+            {
+                shipId = k;
+                defender.fleetSunk[l] = subsetOf(defender.occupied, defender.hits, l);
+            }
+        }
+        else
+            defender.misses.w[w][l] |= bit;
+        if (recordResults)
+            record(attacker, l, t, shotHit, shipId);
+    }
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::record(Side& s, int lane, int cell, bool shotHit, int shipId)
+{
+    if (!s.open[cell][lane])
+        return;
+    setState(s, lane, cell, shotHit ? HIT : MISS);
+    if (!shotHit || shipId < 0)
+        return;
+    //one fewer ship of that length is left to place
+    int i = m_lengthIndex[shipId];
+    if (s.afloat[i][lane] == 0)
+        return;
+    s.afloat[i][lane]--;
+    markSunk(s, lane, cell, m_lengths[i]);
+}
+
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::setState(Side& s, int lane, int cell, CellState state)
+{
+    s.open[cell][lane] = 0;
+    s.value[cell][lane] = (state == HIT ? HIT_BONUS : BLOCKED);
+}
+
+// If exactly one run of hits of the sunk ship's length passes through the
+// cell, those cells are its wreck
+template<int Rows, int Cols, int Lanes>
+void LockstepLanes<Rows, Cols, Lanes>::markSunk(Side& s, int lane, int cell, int length)
+{
+    int pr = cell / Cols;
+    int pc = cell % Cols;
+    int found = 0;
+    int wreckStart = 0;
+    int wreckStep = 1;
+    for (int d = 0; d < 2; d++)
+    {
+        int step = (d == 0 ? 1 : Cols);
+        for (int o = 0; o < length; o++)
+        {
+            int r = pr - (d == 1 ? o : 0);
+            int c = pc - (d == 0 ? o : 0);
+            if (r < 0 || c < 0 || (d == 0 ? c + length > Cols : r + length > Rows))
+                continue;
+            int start = r * Cols + c;
+            int k = 0;
+            while (k < length && s.value[start + k * step][lane] == HIT_BONUS)
+                k++;
+            if (k == length)
+            {
+                found++;
+                wreckStart = start;
+                wreckStep = step;
+            }
+        }
+        //a length-1 ship is found once in each direction
+        if (length == 1)
+            break;
+    }
+    if (found != 1)
+        return;
+    for (int k = 0; k < length; k++)
+        setState(s, lane, wreckStart + k * wreckStep, SUNK);
+}
+
+template<int Rows, int Cols>
+LockstepImpl* newLanes(const Game& g, LockstepEngine::Strategy s1,
+    LockstepEngine::Strategy s2, int lanes)
+{
+    if (lanes <= 8)
+        return new LockstepLanes<Rows, Cols, 8>(g, s1, s2);
+    if (lanes <= 16)
+        return new LockstepLanes<Rows, Cols, 16>(g, s1, s2);
+    return new LockstepLanes<Rows, Cols, 32>(g, s1, s2);
+}
+
+}
+
+//******************** LockstepEngine functions ***********************
+
+bool LockstepEngine::strategyFor(const string& type, Strategy& s)
+{
+    if (type == "awful")
+        s = AWFUL;
+    else if (type == "optimal")
+        s = DENSITY;
+    else
+        return false;
+    return true;
+}
+
+bool LockstepEngine::supports(const Game& g)
+{
+    //one shot a turn
+    if (g.salvo() != 1)
+        return false;
+    //the sizes Board has a FixedBoardImpl for
+    if (!(g.rows() == 10 && g.cols() == 10) && !(g.rows() == 8 && g.cols() == 8) &&
+            !(g.rows() == 2 && g.cols() == 3))
+        return false;
+    //a cell's density never exceeds the weight of every placement of every
+    //ship covering it with all its cells hit, which has to fit in 16 bits
+    long long most = 0;
+    for (int s = 0; s < g.nShips(); s++)
+        most += 2LL * g.shipLength(s) * (1 + 64LL * g.shipLength(s));
+    return most <= 32767;
+}
+
+LockstepEngine::LockstepEngine(const Game& g, Strategy s1, Strategy s2, int lanes)
+{
+    if (g.rows() == 8 && g.cols() == 8)
+        m_impl = newLanes<8, 8>(g, s1, s2, lanes);
+    else if (g.rows() == 2 && g.cols() == 3)
+        m_impl = newLanes<2, 3>(g, s1, s2, lanes);
+    else
+        m_impl = newLanes<10, 10>(g, s1, s2, lanes);
+}
+
+LockstepEngine::~LockstepEngine()
+{
+    delete m_impl;
+}
+
+int LockstepEngine::lanes() const
+{
+    return m_impl->lanes();
+}
+
+void LockstepEngine::run(LockstepSchedule& schedule)
+{
+    m_impl->run(schedule);
+}
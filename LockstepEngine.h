@@ -0,0 +1,77 @@
+#ifndef LOCKSTEPENGINE_INCLUDED
+#define LOCKSTEPENGINE_INCLUDED
+
+#include <string>
+
+class Game;
+class LockstepImpl;
+
+// One game for a LockstepEngine to play
+struct LockstepGame
+{
+    int id;
+    unsigned long long seed1;   // the seed player 1 would be created with
+    unsigned long long seed2;   // and player 2
+    bool p1First;
+};
+
+// Hands games to a LockstepEngine and takes back their results
+class LockstepSchedule
+{
+public:
+    virtual ~LockstepSchedule() {}
+    // Fill in the next game to play.  Returns false once there are none
+    // left.
+    virtual bool nextGame(LockstepGame& game) = 0;
+    // Game id is over.  winner is 1 or 2, or 0 if a player could not place
+    // its ships.
+    virtual void gameOver(int id, int winner, long long shots1, long long shots2) = 0;
+};
+
+// Plays many silent games between two built-in strategies at once, for
+// bulk evaluation.  Each of its lanes (8, 16 or 32) holds a game, and the
+// games' hit, miss and ship bitboards are stored lane by lane, so that one
+// turn of every game is a handful of loops over lanes; the density
+// strategy's are done 8 lanes at a time with SSE2, or 16 with AVX2 when
+// built with -mavx2.  A lane whose game ends starts the next one at once.
+//
+// Attacks are resolved just as Board::attack resolves them, and the
+// strategies play exactly like the players they are named after, so every
+// game ends as Game::play would end it for those players created with the
+// same seeds.  Neither strategy looks at the other player's shots, so the
+// engine fires both players' shots of a turn together and lets the first
+// mover win a turn in which both fleets went down.
+//
+// Only classic games, one shot a turn, on the board sizes with a
+// fixed-size Board implementation are supported.
+class LockstepEngine
+{
+public:
+    enum Strategy {
+        AWFUL,      // AwfulPlayer's sweep from the last cell backwards
+        DENSITY     // OptimalPlayer's placement-density targeting
+    };
+
+    // The strategy that plays exactly like a player of this createPlayer
+    // type.  Returns false if there is none.
+    static bool strategyFor(const std::string& type, Strategy& s);
+    // Whether games of g can be played
+    static bool supports(const Game& g);
+
+    // Player 1 plays s1 and player 2 s2.  lanes is rounded up to 8, 16 or
+    // 32.  g must be supported and must outlive the engine.
+    LockstepEngine(const Game& g, Strategy s1, Strategy s2, int lanes = 16);
+    ~LockstepEngine();
+    int lanes() const;
+    // Play games from schedule until it has no more
+    void run(LockstepSchedule& schedule);
+
+    // We prevent a LockstepEngine object from being copied or assigned
+    LockstepEngine(const LockstepEngine&) = delete;
+    LockstepEngine& operator=(const LockstepEngine&) = delete;
+
+private:
+    LockstepImpl* m_impl;
+};
+
+#endif // LOCKSTEPENGINE_INCLUDED
@@ -0,0 +1,209 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[8] = { 'B', 'S', 'B', 'O', 'O', 'K', '0', '1' };
+}
+
+OpeningBook::OpeningBook()
+    : m_words(nullptr), m_size(0), m_nLines(0), m_mapping(nullptr)
+{}
+
+OpeningBook::OpeningBook(const string& path)
+    : m_words(nullptr), m_size(0), m_nLines(0), m_mapping(nullptr)
+{
+#ifdef _WIN32
+    //no mmap: read the file into memory that is laid out the same way
+    ifstream in(path.c_str(), ios::binary | ios::ate);
+    if (!in)
+        return;
+    streamoff size = in.tellg();
+    if (size <= 0 || size % 4 != 0)
+        return;
+    uint32_t* buffer = new uint32_t[size / 4];
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(buffer), size))
+    {
+        delete [] buffer;
+        return;
+    }
+    m_mapping = buffer;
+    m_words = buffer;
+    m_size = static_cast<size_t>(size);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return;
+    m_mapping = p;
+    m_words = static_cast<const uint32_t*>(p);
+    m_size = st.st_size;
+#endif
+    if (!validate())
+    {
+        release();
+        return;
+    }
+    m_nLines = m_words[2];
+    m_path = path;
+}
+
+OpeningBook::~OpeningBook()
+{
+    release();
+}
+
+void OpeningBook::release()
+{
+    if (m_mapping != nullptr)
+    {
+#ifdef _WIN32
+        delete [] static_cast<uint32_t*>(m_mapping);
+#else
+        munmap(m_mapping, m_size);
+#endif
+    }
+    m_mapping = nullptr;
+    m_words = nullptr;
+    m_size = 0;
+    m_nLines = 0;
+    m_path.clear();
+}
+
+// Check everything a query relies on, so that queries need no checks
+bool OpeningBook::validate() const
+{
+    size_t nWords = m_size / 4;
+    if (m_size % 4 != 0 || nWords < HEADER_WORDS || memcmp(m_words, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    size_t nLines = m_words[2];
+    if (nLines > (nWords - HEADER_WORDS) / DIRECTORY_WORDS)
+        return false;
+    for (size_t line = 0; line < nLines; line++)
+    {
+        const uint32_t* entry = directory(line);
+        size_t keyAt = entry[0];
+        size_t keyWords = entry[1];
+        size_t nodesAt = entry[2];
+        size_t nNodes = entry[3];
+        if (keyAt % 4 != 0 || keyAt / 4 > nWords || keyWords > nWords - keyAt / 4 || keyWords < 2)
+            return false;
+        if (nodesAt % 4 != 0 || nodesAt / 4 > nWords || nNodes > (nWords - nodesAt / 4) / NODE_WORDS)
+            return false;
+        const uint32_t* key = m_words + keyAt / 4;
+        if (key[0] < 1 || key[0] > MAXROWS || key[1] < 1 || key[1] > MAXCOLS)
+            return false;
+        for (size_t n = 0; n < nNodes; n++)
+        {
+            const Node& nd = node(line, n);
+            if (nd.cell >= key[0] * key[1] || nd.onMiss >= nNodes || nd.onHit >= nNodes)
+                return false;
+        }
+    }
+    return true;
+}
+
+const OpeningBook::Node& OpeningBook::node(int line, int n) const
+{
+    return reinterpret_cast<const Node*>(m_words + directory(line)[2] / 4)[n];
+}
+
+int OpeningBook::find(const Game& g) const
+{
+    if (m_nLines == 0)
+        return -1;
+    vector<uint32_t> key;
+    key.push_back(g.rows());
+    key.push_back(g.cols());
+    for (int s = 0; s < g.nShips(); s++)
+        key.push_back(g.shipLength(s));
+    sort(key.begin() + 2, key.end());
+    for (uint32_t line = 0; line < m_nLines; line++)
+    {
+        const uint32_t* entry = directory(line);
+        if (entry[1] == key.size() && entry[3] > 0 &&
+                equal(key.begin(), key.end(), m_words + entry[0] / 4))
+            return line;
+    }
+    return -1;
+}
+
+Point OpeningBook::shot(int line, int n) const
+{
+    uint32_t cols = m_words[directory(line)[0] / 4 + 1];
+    uint32_t cell = node(line, n).cell;
+    return Point(cell / cols, cell % cols);
+}
+
+int OpeningBook::next(int line, int n, bool shotHit, bool shipDestroyed) const
+{
+    if (shipDestroyed)
+        return -1;
+    uint32_t to = (shotHit ? node(line, n).onHit : node(line, n).onMiss);
+    return (to == 0 ? -1 : static_cast<int>(to));
+}
+
+const OpeningBook& OpeningBook::standard()
+{
+    //initialized once, even when several threads get here first
+    //nothing is read unless asked for, so a game replays the same from any
+    //directory
+    static const OpeningBook book(getenv("BATTLESHIP_BOOK") != nullptr ?
+        getenv("BATTLESHIP_BOOK") : "");
+    return book;
+}
+
+bool OpeningBook::write(const string& path, const vector<Line>& lines)
+{
+    vector<uint32_t> words(HEADER_WORDS + DIRECTORY_WORDS * lines.size());
+    memcpy(&words[0], MAGIC, sizeof(MAGIC));
+    words[2] = lines.size();
+    for (size_t line = 0; line < lines.size(); line++)
+    {
+        const Line& l = lines[line];
+        vector<int> lengths(l.lengths);
+        sort(lengths.begin(), lengths.end());
+        size_t entry = HEADER_WORDS + DIRECTORY_WORDS * line;
+        words[entry] = 4 * words.size();
+        words[entry + 1] = 2 + lengths.size();
+        words.push_back(l.rows);
+        words.push_back(l.cols);
+        words.insert(words.end(), lengths.begin(), lengths.end());
+        words[entry + 2] = 4 * words.size();
+        words[entry + 3] = l.nodes.size();
+        for (size_t n = 0; n < l.nodes.size(); n++)
+        {
+            words.push_back(l.nodes[n].cell);
+            words.push_back(l.nodes[n].onMiss);
+            words.push_back(l.nodes[n].onHit);
+        }
+    }
+    ofstream out(path.c_str(), ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&words[0]), 4 * words.size());
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,94 @@
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include "globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+// Precomputed first shots for particular boards and fleets.  The first
+// shots of a game depend only on the board's size, the lengths of the
+// ships and the results so far, so they can be worked out once, offline
+// (tools/BuildBook.cpp), and looked up instead.
+//
+// A book holds one line per board size and fleet.  A line is a tree of
+// nodes, each naming a shot and the node to go to after it missed or hit
+// without sinking anything; a sinking, or a result with no node, leaves the
+// book.  The file is mapped into memory as it is and queried in place, so
+// opening it costs nothing beyond checking that its offsets are in range.
+//
+// File layout, all fields 32-bit unsigned in the byte order of the machine
+// that wrote it, every offset in bytes from the start of the file:
+//     header      magic "BSBOOK01", number of lines
+//     directory   per line: key offset, key words, node offset, node count
+//     keys        rows, cols, then the ship lengths in ascending order
+//     nodes       cell (row * cols + col), node on a miss, node on a hit
+// Node 0 is a line's first shot; since no result leads back to it, 0 also
+// means "no node".
+class OpeningBook
+{
+public:
+    struct Node
+    {
+        std::uint32_t cell;
+        std::uint32_t onMiss;
+        std::uint32_t onHit;
+    };
+    // A line as the book builder produces it
+    struct Line
+    {
+        int rows;
+        int cols;
+        std::vector<int> lengths;           // in any order
+        std::vector<Node> nodes;
+    };
+
+    // An empty book, which has no line for any game
+    OpeningBook();
+    // Map the book in the file at path; if that fails the book is empty
+    explicit OpeningBook(const std::string& path);
+    ~OpeningBook();
+    bool isOpen() const { return m_nLines > 0; }
+    // The file the book was mapped from, or empty if it is empty
+    const std::string& path() const { return m_path; }
+
+    // The line for g's board and fleet, or -1 if the book has none
+    int find(const Game& g) const;
+    // The shot at node of line
+    Point shot(int line, int node) const;
+    // The node that follows node of line after its shot got this result,
+    // or -1 if that leaves the book
+    int next(int line, int node, bool shotHit, bool shipDestroyed) const;
+
+    // The book players consult unless given another: the file named by the
+    // environment variable BATTLESHIP_BOOK, or an empty book if that is not
+    // set.  It is mapped the first time this is called and stays mapped.
+    static const OpeningBook& standard();
+    // Write lines to a book file at path.  Returns false if it could not be
+    // written.
+    static bool write(const std::string& path, const std::vector<Line>& lines);
+
+    // We prevent an OpeningBook object from being copied or assigned
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+private:
+    enum { HEADER_WORDS = 3, DIRECTORY_WORDS = 4, NODE_WORDS = 3 };
+
+    const std::uint32_t* m_words;           // the whole file
+    std::size_t m_size;                     // in bytes
+    std::uint32_t m_nLines;
+    void* m_mapping;                        // what to release, if anything
+    std::string m_path;
+
+    const std::uint32_t* directory(int line) const
+        { return m_words + HEADER_WORDS + DIRECTORY_WORDS * line; }
+    const Node& node(int line, int n) const;
+    bool validate() const;
+    void release();
+};
+
+#endif // OPENINGBOOK_INCLUDED
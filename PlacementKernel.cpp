@@ -0,0 +1,220 @@
+#include "PlacementKernel.h"
+#include <algorithm>
+#include <vector>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// The Ops types and pass helpers are private to this file
+namespace
+{
+
+// Each Ops type exposes the handful of lane-wise int32 operations the pass
+// needs, LANES at a time
+
+struct ScalarOps
+{
+    typedef int V;
+    enum { LANES = 1 };
+    static V load(const int* p) { return *p; }
+    static void store(int* p, V v) { *p = v; }
+    static V set1(int x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V band(V a, V b) { return a & b; }
+};
+
+#if defined(__SSE2__)
+struct Sse2Ops
+{
+    typedef __m128i V;
+    enum { LANES = 4 };
+    static V load(const int* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static V set1(int x) { return _mm_set1_epi32(x); }
+    static V add(V a, V b) { return _mm_add_epi32(a, b); }
+    static V band(V a, V b) { return _mm_and_si128(a, b); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2Ops
+{
+    typedef __m256i V;
+    enum { LANES = 8 };
+    static V load(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V set1(int x) { return _mm256_set1_epi32(x); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static V band(V a, V b) { return _mm256_and_si256(a, b); }
+};
+#endif
+
+// Weights of the placements starting at each of the first n cells of a
+// padded row-major grid, whose cells lie step apart (step 1 runs across a
+// row, the row stride runs down a column).  free is -1 for usable cells and
+// 0 for blocked or padding ones; hits is -1 for hit cells and 0 otherwise.  A placement
+// covering h hits weighs base + bonus * h, or 0 if any of its cells is
+// blocked.
+template<typename Ops>
+void windowWeights(const int* free, const int* hits, int n, int step,
+    int length, int base, int bonus, int* weights)
+{
+    typedef typename Ops::V V;
+    V vbase = Ops::set1(base);
+    V vbonus = Ops::set1(bonus);
+    for (int i = 0; i < n; i += Ops::LANES)
+    {
+        V ok = Ops::load(free + i);
+        V weight = Ops::add(vbase, Ops::band(vbonus, Ops::load(hits + i)));
+        for (int k = 1; k < length; k++)
+        {
+            ok = Ops::band(ok, Ops::load(free + i + k * step));
+            weight = Ops::add(weight, Ops::band(vbonus, Ops::load(hits + i + k * step)));
+        }
+        Ops::store(weights + i, Ops::band(ok, weight));
+    }
+}
+
+// sums[r][c] = total weight of the down placements covering (r, c)
+template<typename Ops>
+void downSums(const int* weights, int rows, int stride, int length, int* sums)
+{
+    typedef typename Ops::V V;
+    for (int r = 0; r < rows; r++)
+    {
+        //starts from r - length + 1 to r, clipped to the grid
+        int first = (r - length + 1 > 0 ? r - length + 1 : 0);
+        int last = (r + length <= rows ? r : rows - length);
+        for (int c = 0; c < stride; c += Ops::LANES)
+        {
+            V total = Ops::set1(0);
+            for (int s = first; s <= last; s++)
+                total = Ops::add(total, Ops::load(weights + s * stride + c));
+            Ops::store(sums + r * stride + c, total);
+        }
+    }
+}
+
+// sums[i] += total weight of the across placements covering cell i.  The
+// length - 1 cells before weights[0] must be readable zeros.
+template<typename Ops>
+void acrossSums(const int* weights, int n, int length, int* sums)
+{
+    typedef typename Ops::V V;
+    for (int i = 0; i < n; i += Ops::LANES)
+    {
+        V total = Ops::load(sums + i);
+        for (int k = 0; k < length; k++)
+            total = Ops::add(total, Ops::load(weights + i - k));
+        Ops::store(sums + i, total);
+    }
+}
+
+template<typename Ops>
+void bothPasses(const int* free, const int* hits, int rows, int cols,
+    int stride, int length, int base, int bonus, int* weights, int* sums)
+{
+    if (length <= rows)
+    {
+        windowWeights<Ops>(free, hits, (rows - length + 1) * stride, stride,
+            length, base, bonus, weights);
+        downSums<Ops>(weights, rows, stride, length, sums);
+    }
+    else
+        fill(sums, sums + rows * stride, 0);
+    if (length <= cols)
+    {
+        //a window that runs off the end of a row covers a padding cell, so
+        //it weighs nothing
+        windowWeights<Ops>(free, hits, rows * stride, 1, length, base, bonus, weights);
+        acrossSums<Ops>(weights, rows * stride, length, sums);
+    }
+}
+
+const int PAD = 8;
+
+// At least one padding cell ends every row, rounded up to whole vectors
+int paddedStride(int nCols)
+{
+    return (nCols + PAD) / PAD * PAD;
+}
+
+}
+
+PlacementKernel::PlacementKernel(int nRows, int nCols, Path path)
+    : m_rows(nRows), m_cols(nCols), m_stride(paddedStride(nCols)),
+      m_free((nRows + 1) * m_stride, 0), m_hits((nRows + 1) * m_stride, 0),
+      m_weights((nRows + 1) * m_stride, 0), m_sums(nRows * m_stride, 0)
+{
+    Path best = SCALAR;
+#if defined(__AVX2__)
+    best = AVX2;
+#elif defined(__SSE2__)
+    best = SSE2;
+#endif
+    m_path = (path == BEST || path > best ? best : path);
+}
+
+const char* PlacementKernel::pathName(Path path)
+{
+    switch (path)
+    {
+    case SCALAR: return "scalar";
+    case SSE2:   return "sse2";
+    case AVX2:   return "avx2";
+    default:     return "best";
+    }
+}
+
+void PlacementKernel::setBoard(const unsigned char* blocked, const unsigned char* hits)
+{
+    //padding cells and the extra row at the end stay blocked
+    for (int r = 0; r < m_rows; r++)
+    {
+        int* free = &m_free[r * m_stride];
+        int* hitRow = &m_hits[r * m_stride];
+        for (int c = 0; c < m_cols; c++)
+        {
+            free[c] = (blocked[r * m_cols + c] ? 0 : -1);
+            hitRow[c] = (hits[r * m_cols + c] ? -1 : 0);
+        }
+    }
+}
+
+void PlacementKernel::accumulate(int length, int hitBonus, int multiplier, int* density)
+{
+    if (length < 1 || multiplier == 0 || (length > m_rows && length > m_cols))
+        return;
+    //weights are written after a row of zeros that across sums read past
+    int* weights = &m_weights[m_stride];
+    int base = multiplier;
+    int bonus = multiplier * hitBonus;
+    switch (m_path)
+    {
+#if defined(__AVX2__)
+    case AVX2:
+        bothPasses<Avx2Ops>(&m_free[0], &m_hits[0], m_rows, m_cols, m_stride,
+            length, base, bonus, weights, &m_sums[0]);
+        break;
+#endif
+#if defined(__SSE2__)
+    case SSE2:
+        bothPasses<Sse2Ops>(&m_free[0], &m_hits[0], m_rows, m_cols, m_stride,
+            length, base, bonus, weights, &m_sums[0]);
+        break;
+#endif
+    default:
+        bothPasses<ScalarOps>(&m_free[0], &m_hits[0], m_rows, m_cols, m_stride,
+            length, base, bonus, weights, &m_sums[0]);
+        break;
+    }
+    for (int r = 0; r < m_rows; r++)
+    {
+        const int* sums = &m_sums[r * m_stride];
+        int* out = density + r * m_cols;
+        for (int c = 0; c < m_cols; c++)
+            out[c] += sums[c];
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef PLACEMENTKERNEL_INCLUDED
+#define PLACEMENTKERNEL_INCLUDED
+
+#include <vector>
+
+// Counts, for every cell of an nRows x nCols board, the placements of a
+// ship of a given length that cover it and avoid every blocked cell.  Each
+// placement is weighted 1 + hitBonus * (number of hit cells it covers), so
+// a hit-free board gives plain placement counts.
+//
+// Both directions are sliding-window passes over one padded row-major grid,
+// stepping a whole row (down) or one cell (across) per ship segment.  They
+// are vectorized with AVX2 when the compiler targets it, with SSE2 on any
+// other x86-64 build, and run as scalar loops elsewhere.  Grid rows end in
+// at least one blocked padding cell and are rounded up to a multiple of
+// eight cells, so across windows never wrap into the next row and no lane
+// is ever left over.
+class PlacementKernel
+{
+public:
+    enum Path { SCALAR, SSE2, AVX2, BEST };
+
+    // Uses the requested instruction set, or the best one available if it
+    // was not compiled in
+    PlacementKernel(int nRows, int nCols, Path path = BEST);
+
+    // Load the shots so far.  blocked and hits hold one byte per cell,
+    // row-major, nonzero where the cell is blocked (a miss or a sunk ship)
+    // or an unsunk hit.
+    void setBoard(const unsigned char* blocked, const unsigned char* hits);
+
+    // Add multiplier times the weighted count of the placements of a ship
+    // of the given length covering each cell to density[r * nCols + c]
+    void accumulate(int length, int hitBonus, int multiplier, int* density);
+
+    Path path() const { return m_path; }
+    static const char* pathName(Path path);
+
+private:
+    int m_rows;
+    int m_cols;
+    int m_stride;       // padded row length of the grid
+    Path m_path;
+    // int32 working copies of the inputs, the per-start weights of the
+    // current direction and the per-cell sums of both
+    std::vector<int> m_free;
+    std::vector<int> m_hits;
+    std::vector<int> m_weights;
+    std::vector<int> m_sums;
+};
+
+#endif // PLACEMENTKERNEL_INCLUDED
@@ -2,12 +2,38 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "FleetPlacer.h"
+#include "DensityMap.h"
+#include "LayoutSampler.h"
+#include "EndgameSolver.h"
+#include "OpeningBook.h"
 #include <iostream>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+Player::Player(string nm, const Game& g)
+    : m_name(nm), m_game(g), m_rng(g.nextSeed()), m_knowledge(g)
+{}
+
+void Player::reset()
+{
+    //the Game clears the knowledge board when the game starts
+    m_rng.seed(m_game.nextSeed());
+}
+
+void Player::recommendAttacks(Point* shots, int k)
+{
+    for (int j = 0; j < k; j++)
+        shots[j] = recommendAttack();
+}
+
+Point Player::randomPoint()
+{
+    return Point(randInt(m_game.rows()), randInt(m_game.cols()));
+}
+
 //*********************************************************************
 //  AwfulPlayer
 //*********************************************************************
@@ -20,6 +46,7 @@ public:
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
 private:
     Point m_lastCellAttacked;
 };
@@ -64,6 +91,12 @@ void AwfulPlayer::recordAttackByOpponent(Point /* p */)
     // AwfulPlayer completely ignores what the opponent does
 }
 
+void AwfulPlayer::reset()
+{
+    Player::reset();
+    m_lastCellAttacked = Point(0, 0);
+}
+
 //*********************************************************************
 //  HumanPlayer
 //*********************************************************************
@@ -218,6 +251,94 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
 //  MediocrePlayer
 //*********************************************************************
 
+// The cells a player may still attack: those its knowledge board has not
+// seen tried, less the shots held for the salvo being chosen, which the
+// board only learns of once the salvo is resolved
+class UntriedCells
+{
+public:
+    UntriedCells(const Game& g, const KnowledgeBoard& known)
+        : m_rows(g.rows()), m_cols(g.cols()), m_known(known),
+          m_held(g.rows() * g.cols(), 0), m_nHeld(0)
+    {}
+    bool contains(Point p) const
+        { return !m_known.isTried(p) && (m_nHeld == 0 || !m_held[p.r * m_cols + p.c]); }
+    int size() const { return m_rows * m_cols - m_known.nTried() - m_nHeld; }
+    // A uniformly random one; there must be one
+    Point random(Rng& rng) const;
+    // Leave p out until it is released, if it is in
+    void hold(Point p);
+    void release(Point p);
+private:
+    // What one random draw costs in cells looked at while counting
+    enum { DRAW_COST = 16 };
+    int m_rows;
+    int m_cols;
+    const KnowledgeBoard& m_known;
+    vector<char> m_held;            // per cell
+    int m_nHeld;
+};
+
+Point UntriedCells::random(Rng& rng) const
+{
+    //random cells find one in cells / n draws on average, and counting up
+    //to a random one looks at every word of the mask and half the cells
+    //left; do whichever is cheaper, which over a game adds up to
+    //O(cells log cells)
+    const vector<uint64_t>& tried = m_known.triedMask();
+    int cells = m_rows * m_cols;
+    int n = size();
+    long long countCost = tried.size() + n / 2;
+    while (DRAW_COST * static_cast<long long>(cells) <= n * countCost)
+    {
+        int cell = rng.randInt(cells);
+        Point p(cell / m_cols, cell % m_cols);
+        if (contains(p))
+            return p;
+    }
+    int skip = rng.randInt(n);
+    for (int k = 0; ; k++)
+    {
+        //the untried cells of each word, lowest first; the bits past the
+        //last cell are never reached
+        for (uint64_t open = ~tried[k]; open != 0; open &= open - 1)
+        {
+            int cell = 64 * k + __builtin_ctzll(open);
+            if ((m_nHeld == 0 || !m_held[cell]) && skip-- == 0)
+                return Point(cell / m_cols, cell % m_cols);
+        }
+    }
+}
+
+void UntriedCells::hold(Point p)
+{
+    if (contains(p))
+    {
+        m_held[p.r * m_cols + p.c] = 1;
+        m_nHeld++;
+    }
+}
+
+void UntriedCells::release(Point p)
+{
+    if (!m_held[p.r * m_cols + p.c])
+        return;
+    m_held[p.r * m_cols + p.c] = 0;
+    m_nHeld--;
+}
+
+// Collect into options the candidates still in untried
+void untriedCandidates(const vector<Point>& candidates, const UntriedCells& untried,
+    vector<Point>& options)
+{
+    options.clear();
+    for (size_t k = 0; k < candidates.size(); k++)
+    {
+        if (untried.contains(candidates[k]))
+            options.push_back(candidates[k]);
+    }
+}
+
  class MediocrePlayer : public Player
  {
  public:
@@ -225,18 +346,32 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
      virtual bool isHuman() const;
      virtual bool placeShips(Board& b);
      virtual Point recommendAttack();
+     virtual void recommendAttacks(Point* shots, int k);
      virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
      virtual void recordAttackByOpponent(Point p); 
-     bool helperPlaceShips(int index, Board& b);
+     virtual void reset();
  private:
+     // Placement checks the first-fit layout may make before the placer
+     // takes over
+     enum { PLACE_BUDGET = 20000 };
+     bool helperPlaceShips(int index, Board& b);
+     Point nextAttack(bool endHunt);
      int state; 
-     vector<Point> attackedPositions; 
+     int placeBudget;
+     FleetPlacer placer;
+     UntriedCells untried;
      vector<Point> StateTwoOptions; 
+     vector<Point> options;         // untried StateTwoOptions, rebuilt each move
      Point hit_location; 
  };
 
- MediocrePlayer::MediocrePlayer(string nm, const Game& g) : Player(nm, g), state(1)
- {}
+ MediocrePlayer::MediocrePlayer(string nm, const Game& g)
+     : Player(nm, g), state(1), placeBudget(0), placer(g), untried(g, knowledge())
+ {
+     //room for every cell within 4 of a hit, so no move has to allocate
+     StateTwoOptions.reserve(16);
+     options.reserve(16);
+ }
 
  bool MediocrePlayer::isHuman() const
  {
@@ -245,55 +380,58 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
 
  bool MediocrePlayer::placeShips(Board& b)
  {
+     //block half the board, or less if the fleet needs more than half of
+     //what is left, so that at least twice the fleet's cells stay free
+     int cells = game().rows() * game().cols();
+     int fleetCells = 0;
+     for (int s = 0; s < game().nShips(); s++)
+         fleetCells += game().shipLength(s);
+     double fraction = 1.0 - 2.0 * fleetCells / cells;
+     fraction = (fraction > 0.5 ? 0.5 : fraction < 0 ? 0 : fraction);
      int attempts = 0; 
-     //atempt 50 times to place ships 
+     //atempt 50 times to place ships on the unblocked part of the board,
+     //blocking less each time so the last attempt has the whole board
      while (attempts <= 50)
      {
-         b.block();
-         //failure
-         if (!helperPlaceShips(0, b))
-         {
-             attempts++;
-             b.unblock();
-         }
-         //success
-         else
-         {
-             b.unblock();
-             return true; 
-         }
+         b.block(fraction * (50 - attempts) / 50);
+         //lay the fleet out first-fit, which finds a layout if there is
+         //one, and search for it instead only if that takes too many tries
+         placeBudget = PLACE_BUDGET;
+         bool placed = helperPlaceShips(0, b);
+         if (!placed && placeBudget < 0)
+             placed = placer.placeShips(b, rng());
+         b.unblock();
+         if (placed)
+             return true;
+         attempts++;
      }
      return false; 
  }
 
- //recursive algorithm (helper function) 
+ //recursive algorithm (helper function): place each ship at the first
+ //cell, in reading order, where it and the ships after it fit
  bool MediocrePlayer :: helperPlaceShips(int index, Board& b)
  {
      if (index == Player::game().nShips())
          return true;
      //for loop that runs through entire board
-     for(int row_incrementer = 0; row_incrementer < Player::game().rows(); row_incrementer++)
+     for (int row_incrementer = 0; row_incrementer < Player::game().rows(); row_incrementer++)
      {
          for (int col_incrementer = 0; col_incrementer < Player::game().cols(); col_incrementer++)
          {
-             
-             //horizontal case 
-             if (b.placeShip(Point(row_incrementer, col_incrementer), index, HORIZONTAL))
-             {
-                 bool returnValue = helperPlaceShips(index + 1, b);
-                 if (returnValue)
-                     return true;
-                 else
-                     b.unplaceShip(Point(row_incrementer, col_incrementer), index, HORIZONTAL);
-             }
-             //vertical case
-             if (b.placeShip(Point(row_incrementer, col_incrementer), index, VERTICAL))
+             Point p(row_incrementer, col_incrementer);
+             //horizontal case, then vertical case
+             for (int d = 0; d < 2; d++)
              {
-                 bool returnValue = helperPlaceShips(index + 1, b);
-                 if (returnValue)
-                     return true;
-                 else
-                     b.unplaceShip(Point(row_incrementer, col_incrementer), index, VERTICAL);
+                 Direction dir = (d == 0 ? HORIZONTAL : VERTICAL);
+                 if (--placeBudget < 0)
+                     return false;
+                 if (b.placeShip(p, index, dir))
+                 {
+                     if (helperPlaceShips(index + 1, b))
+                         return true;
+                     b.unplaceShip(p, index, dir);
+                 }
              }
          }
      }
@@ -302,72 +440,47 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
 
  Point MediocrePlayer :: recommendAttack()
  {
-     Point attackpos; 
-     int counter = 0;
-     bool match_found = false; 
-     if (state == 1)
+     return nextAttack(true);
+ }
+
+ void MediocrePlayer::recommendAttacks(Point* shots, int k)
+ {
+     //only the first shot knows the results of every earlier one, so only
+     //it may give up on the ship being hunted
+     for (int j = 0; j < k; j++)
      {
-         //find unique attack point
-         attackpos = Player::game().randomPoint();
-         while(counter == 0)
-         {
-             for (int i = 0; i < attackedPositions.size(); i++)
-             {
-                 counter++;
-                 if ((attackedPositions[i].r == attackpos.r) && (attackedPositions[i].c == attackpos.c))
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0; 
-                     break;
-                 }
-             }
-             if (counter == attackedPositions.size())
-                 break;
-         }
-         attackedPositions.push_back(attackpos); 
-         return attackpos; 
+         shots[j] = nextAttack(j == 0);
+         untried.hold(shots[j]);
      }
+     //the knowledge board has them once the salvo is resolved
+     for (int j = 0; j < k; j++)
+         untried.release(shots[j]);
+ }
 
+ // The next cell to attack, never one tried or held.  Once every cell the
+ // hunted ship could extend to has been, the pick is random, and with
+ // endHunt the hunt is over.
+ Point MediocrePlayer::nextAttack(bool endHunt)
+ {
+     Point attackpos; 
+     if (untried.size() == 0)
+         return Point(0, 0);
      if (state == 2)
      {
-         //find unique attack point
-         attackpos = Player::game().randomPoint();
-         while (counter == 0)
+         untriedCandidates(StateTwoOptions, untried, options);
+         //every cell the ship could extend to has been tried, so go back to random attacks
+         if (options.empty() && endHunt)
          {
-             for (int i = 0; i < attackedPositions.size(); i++)
-             {
-                 counter++;
-                 if ((attackedPositions[i].r == attackpos.r) && (attackedPositions[i].c == attackpos.c))
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                     break;
-                 }
-             }
-             if (counter == attackedPositions.size())
-             {
-                 //check if the random attack point is able to be done given the vector StateTwoOptions
-                 for (int k = 0; k < StateTwoOptions.size(); k++)
-                 {
-                     if ((StateTwoOptions[k].r == attackpos.r) && (StateTwoOptions[k].c == attackpos.c))
-                     {
-                         match_found = true; 
-                         break; 
-                     }
-                 }
-                 if (match_found)
-                     break; 
-                 else
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                 }
-             }
+             state = 1;
+             StateTwoOptions.clear();
          }
-         attackedPositions.push_back(attackpos);
-         return attackpos;
      }
-     return Point(0, 0);
+     //pick a uniformly random untried cell (among the candidates in state 2)
+     if (state == 2 && !options.empty())
+         attackpos = options[randInt(options.size())];
+     else
+         attackpos = untried.random(rng());
+     return attackpos; 
  }
 
  void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
@@ -412,6 +525,13 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
      //do nothing 
  }
 
+ void MediocrePlayer::reset()
+ {
+     Player::reset();
+     state = 1;
+     StateTwoOptions.clear();
+ }
+
 //*********************************************************************
 //  GoodPlayer
 //*********************************************************************
@@ -423,22 +543,32 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
      virtual bool isHuman() const;
      virtual bool placeShips(Board& b);
      virtual Point recommendAttack();
+     virtual void recommendAttacks(Point* shots, int k);
      virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
      virtual void recordAttackByOpponent(Point p);
-     bool helperPlaceShips(int index, Board& b);
+     virtual void reset();
  private:
+     Point nextAttack(bool endHunt);
      int state; 
      Point firstHit; 
-     vector <Point> pointsOfOptimalAttack; 
-     vector <Point> attackedPositions; 
+     FleetPlacer placer;
+     UntriedCells untried;
      vector <Point> pointsOfOptimalAttack_2; 
      vector <Point> pointsOfOptimalAttack_3; 
+     vector <Point> options;        // untried candidates, rebuilt each move
  };
 
 
 
- GoodPlayer::GoodPlayer(string nm, const Game& g) : Player(nm, g), state(1)
+ GoodPlayer::GoodPlayer(string nm, const Game& g)
+     : Player(nm, g), state(1), placer(g), untried(g, knowledge())
  {
+     //room for the most candidates either state can list, so no move has
+     //to allocate; a salvo can report a second hit diagonal to the first,
+     //which lists both directions
+     pointsOfOptimalAttack_2.reserve(4);
+     pointsOfOptimalAttack_3.reserve(16);
+     options.reserve(16);
  }
 
  bool GoodPlayer::isHuman() const
@@ -448,190 +578,57 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
 
  bool GoodPlayer :: placeShips(Board& b)
  {
-     int attempts = 0;
-     while (attempts <= 1000000)
-     {
-         //failure
-         if (!helperPlaceShips(0, b))
-         {
-             attempts++;
-         }
-         //success
-         else
-         {
-             return true;
-         }
-     }
-     return false;
+     //a uniformly random layout of the whole fleet, or for a fleet too
+     //dense for that the placer's search's pick
+     return placer.placeShips(b, rng());
  }
 
- //helper function to place ships 
- bool GoodPlayer::helperPlaceShips(int index, Board& b)
+ Point GoodPlayer::recommendAttack()
  {
-     if (index == Player::game().nShips())
-         return true;
-     Point place_point = Player::game().randomPoint();
-     //horizontal case 
-     if (b.placeShip(place_point, index, HORIZONTAL))
-             {
-                 bool returnValue = helperPlaceShips(index + 1, b);
-                 if (returnValue)
-                     return true;
-                 else
-                     b.unplaceShip(place_point, index, HORIZONTAL);
-             }
-     //vertical case
-     if (b.placeShip(place_point, index, VERTICAL))
-             {
-                 bool returnValue = helperPlaceShips(index + 1, b);
-                 if (returnValue)
-                     return true;
-                 else
-                     b.unplaceShip(place_point, index, VERTICAL);
-             }
-     return false;
+     return nextAttack(true);
  }
 
- Point GoodPlayer::recommendAttack()
+ void GoodPlayer::recommendAttacks(Point* shots, int k)
  {
-     Point attackpos;
-     int counter = 0;
-     bool match_found = false; 
-     if (state == 1)
-     {
-         //find unique attack point
-         attackpos = Player::game().randomPoint();
-         while (counter == 0)
-         {
-             for (int i = 0; i < attackedPositions.size(); i++)
-             {
-                 counter++;
-                 if ((attackedPositions[i].r == attackpos.r) && (attackedPositions[i].c == attackpos.c))
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                     break;
-                 }
-             }
-             if (counter == attackedPositions.size())
-                 break;
-         }
-         attackedPositions.push_back(attackpos);
-         return attackpos;
-     }
-
-     //attack only 1 square in cardinal directions around hit location (state 2) to search for ship 
-     if (state == 2)
+     //only the first shot knows the results of every earlier one, so only
+     //it may give up on the ship being hunted
+     for (int j = 0; j < k; j++)
      {
-         int count_1 = 0;
-         //what if all spots in the vector have been attacked? 
-         for (int i = 0; i < pointsOfOptimalAttack_2.size(); i++)
-         {
-             for (int u = 0; u < attackedPositions.size(); u++)
-             {
-                 if ((pointsOfOptimalAttack_2[i].r == attackedPositions[u].r) && (pointsOfOptimalAttack_2[i].c == attackedPositions[u].c))
-                     count_1++;
-             }
-         }
-         if (count_1 == pointsOfOptimalAttack_2.size())
-         {
-             state = 1;
-             return recommendAttack();
-         }
-         //find unique attack point
-         attackpos = Player::game().randomPoint();
-         while (counter == 0)
-         {
-             for (int i = 0; i < attackedPositions.size(); i++)
-             {
-                 counter++;
-                 if ((attackedPositions[i].r == attackpos.r) && (attackedPositions[i].c == attackpos.c))
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                     break;
-                 }
-             }
-             if (counter == attackedPositions.size())
-             {
-                 //check if the random attack point is able to be done given the vector pointsOfOptimalAttack_2
-                 for (int k = 0; k < pointsOfOptimalAttack_2.size(); k++)
-                 {
-                     if ((pointsOfOptimalAttack_2[k].r == attackpos.r) && (pointsOfOptimalAttack_2[k].c == attackpos.c))
-                     {
-                         match_found = true;
-                         break;
-                     }
-                 }
-                 if (match_found)
-                     break;
-                 else
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                 }
-             }
-         }
-         attackedPositions.push_back(attackpos);
-         return attackpos;
+         shots[j] = nextAttack(j == 0);
+         untried.hold(shots[j]);
      }
+     //the knowledge board has them once the salvo is resolved
+     for (int j = 0; j < k; j++)
+         untried.release(shots[j]);
+ }
 
-     //if we have locked onto a target, initiate state 3 (attack along cardinal direction until ship is destroyed) 
-     if (state == 3)
+ // The next cell to attack, never one tried or held.  Once every candidate
+ // around the hunted ship has been, the pick is random, and with endHunt
+ // the hunt is over.
+ Point GoodPlayer::nextAttack(bool endHunt)
+ {
+     Point attackpos;
+     if (untried.size() == 0)
+         return Point(0, 0);
+     //state 2 attacks only 1 square in cardinal directions around the hit location;
+     //state 3 has locked onto a target and attacks along its direction until it is destroyed
+     if (state == 2 || state == 3)
      {
-         int count_1 = 0;
+         untriedCandidates(state == 2 ? pointsOfOptimalAttack_2 : pointsOfOptimalAttack_3, untried, options);
          //what if all spots in the vector have been attacked? 
-         for (int i = 0; i < pointsOfOptimalAttack_3.size(); i++)
-         {
-             for (int u = 0; u < attackedPositions.size(); u++)
-             {
-                 if ((pointsOfOptimalAttack_3[i].r == attackedPositions[u].r) && (pointsOfOptimalAttack_3[i].c == attackedPositions[u].c))
-                     count_1++;
-             }
-         }
-         if (count_1 == pointsOfOptimalAttack_3.size())
+         if (options.empty() && endHunt)
          {
              state = 1;
-             return recommendAttack();
+             pointsOfOptimalAttack_2.clear();
+             pointsOfOptimalAttack_3.clear();
          }
-         //find unique attack point
-         attackpos = Player::game().randomPoint();
-         while (counter == 0)
-         {
-             for (int i = 0; i < attackedPositions.size(); i++)
-             {
-                 counter++;
-                 if ((attackedPositions[i].r == attackpos.r) && (attackedPositions[i].c == attackpos.c))
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                     break;
-                 }
-             }
-             if (counter == attackedPositions.size())
-             {
-                 //check if the random attack point is able to be done given the vector pointsOfOptimalAttack_3
-                 for (int k = 0; k < pointsOfOptimalAttack_3.size(); k++)
-                 {
-                     if ((pointsOfOptimalAttack_3[k].r == attackpos.r) && (pointsOfOptimalAttack_3[k].c == attackpos.c))
-                     {
-                         match_found = true;
-                         break;
-                     }
-                 }
-                 if (match_found)
-                     break;
-                 else
-                 {
-                     attackpos = Player::game().randomPoint();
-                     counter = 0;
-                 }
-             }
-         }
-         attackedPositions.push_back(attackpos);
-         return attackpos;
      }
-     return Point(0, 0);
+     //pick a uniformly random untried cell (among the candidates in states 2 and 3)
+     if (state == 1 || options.empty())
+         attackpos = untried.random(rng());
+     else
+         attackpos = options[randInt(options.size())];
+     return attackpos;
  }
 
  void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
@@ -716,6 +713,244 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
      //do nothing 
  }
 
+ void GoodPlayer::reset()
+ {
+     Player::reset();
+     state = 1;
+     pointsOfOptimalAttack_2.clear();
+     pointsOfOptimalAttack_3.clear();
+ }
+
+//*********************************************************************
+//  OptimalPlayer
+//*********************************************************************
+
+ // Places its ships like a GoodPlayer, but always attacks the cell that the
+ // most placements of the remaining ships could cover
+ class OptimalPlayer : public GoodPlayer
+ {
+ public:
+     OptimalPlayer(string nm, const Game& g);
+     virtual Point recommendAttack();
+     virtual void recommendAttacks(Point* shots, int k);
+     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+     virtual void reset();
+ private:
+     DensityMap density;
+ };
+
+ OptimalPlayer::OptimalPlayer(string nm, const Game& g) : GoodPlayer(nm, g), density(g)
+ {}
+
+ Point OptimalPlayer::recommendAttack()
+ {
+     return density.best();
+ }
+
+ void OptimalPlayer::recommendAttacks(Point* shots, int k)
+ {
+     //the k densest cells
+     density.best(shots, k);
+ }
+
+ void OptimalPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+ {
+     if (validShot)
+         density.record(p, shotHit, shipDestroyed, shipId);
+ }
+
+ void OptimalPlayer::reset()
+ {
+     GoodPlayer::reset();
+     density.reset();
+ }
+
+//*********************************************************************
+//  MonteCarloPlayer
+//*********************************************************************
+
+ // Places its ships like a GoodPlayer, but attacks the untried cell that
+ // holds a ship in the largest weighted share of random fleet layouts
+ // consistent with what it has seen.  Each move samples up to samplesPerMove layouts spread over
+ // nThreads threads, stopping after secondsPerMove if that is positive.
+ // While its opening book has a shot for the results so far, it takes that
+ // instead of sampling.
+ class MonteCarloPlayer : public GoodPlayer
+ {
+ public:
+     MonteCarloPlayer(string nm, const Game& g, int samplesPerMove,
+         double secondsPerMove, int nThreads, string bookPath);
+     virtual Point recommendAttack();
+     virtual void recommendAttacks(Point* shots, int k);
+     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+     virtual void reset();
+ private:
+     LayoutSampler sampler;
+     DensityMap density;            // fallback when no layout is found in time
+     OpeningBook ownBook;           // the book at the path given, if any
+     const OpeningBook& book;       // ownBook, or with no path the standard one
+     int bookLine;                  // this game's line of the book, or -1
+     int bookNode;                  // where the game is in it, or -1 once out
+     int samples;
+     double seconds;
+     int threads;
+     unsigned long long baseSeed;
+     int moves;
+     vector<double> counts;
+ };
+
+ MonteCarloPlayer::MonteCarloPlayer(string nm, const Game& g, int samplesPerMove,
+     double secondsPerMove, int nThreads, string bookPath)
+     : GoodPlayer(nm, g), sampler(g), density(g), ownBook(bookPath),
+       book(bookPath.empty() ? OpeningBook::standard() : ownBook),
+       samples(samplesPerMove), seconds(secondsPerMove), threads(nThreads), moves(0)
+ {
+     bookLine = book.find(g);
+     bookNode = (bookLine >= 0 ? 0 : -1);
+     baseSeed = (static_cast<unsigned long long>(randInt(1 << 30)) << 30) | randInt(1 << 30);
+ }
+
+ Point MonteCarloPlayer::recommendAttack()
+ {
+     moves++;
+     if (bookNode >= 0)
+         return book.shot(bookLine, bookNode);
+     if (sampler.sample(mixSeed(baseSeed + moves), samples, seconds, threads, counts) == 0)
+         return density.best();
+     Point best = density.best();
+     double bestCount = -1;
+     for (int r = 0; r < game().rows(); r++)
+     {
+         for (int c = 0; c < game().cols(); c++)
+         {
+             double count = counts[r * game().cols() + c];
+             if (count > bestCount && !knowledge().isTried(Point(r, c)))
+             {
+                 best = Point(r, c);
+                 bestCount = count;
+             }
+         }
+     }
+     return best;
+ }
+
+ void MonteCarloPlayer::recommendAttacks(Point* shots, int k)
+ {
+     if (k == 1)
+     {
+         shots[0] = recommendAttack();
+         return;
+     }
+     //the book only follows single shots
+     bookNode = -1;
+     moves++;
+     if (sampler.sample(mixSeed(baseSeed + moves), samples, seconds, threads, counts) == 0)
+     {
+         density.best(shots, k);
+         return;
+     }
+     //the k untried cells in the most layouts, the lowest of equals first
+     int cols = game().cols();
+     int found = 0;
+     for (int cell = 0; cell < game().rows() * cols; cell++)
+     {
+         Point p(cell / cols, cell % cols);
+         if (knowledge().isTried(p) ||
+                 (found == k && counts[cell] <= counts[shots[k - 1].r * cols + shots[k - 1].c]))
+             continue;
+         int j = (found < k ? found++ : k - 1);
+         for (; j > 0 && counts[shots[j - 1].r * cols + shots[j - 1].c] < counts[cell]; j--)
+             shots[j] = shots[j - 1];
+         shots[j] = p;
+     }
+     for (int j = found; j < k; j++)
+         shots[j] = Point(0, 0);
+ }
+
+ void MonteCarloPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+ {
+     if (bookNode >= 0)
+     {
+         //a shot the book did not call also leaves it
+         Point expected = book.shot(bookLine, bookNode);
+         if (validShot && p.r == expected.r && p.c == expected.c)
+             bookNode = book.next(bookLine, bookNode, shotHit, shipDestroyed);
+         else
+             bookNode = -1;
+     }
+     if (!validShot)
+         return;
+     sampler.record(p, shotHit, shipDestroyed, shipId);
+     density.record(p, shotHit, shipDestroyed, shipId);
+ }
+
+ void MonteCarloPlayer::reset()
+ {
+     GoodPlayer::reset();
+     sampler.reset();
+     density.reset();
+     bookNode = (bookLine >= 0 ? 0 : -1);
+     baseSeed = (static_cast<unsigned long long>(randInt(1 << 30)) << 30) | randInt(1 << 30);
+     moves = 0;
+ }
+
+//*********************************************************************
+//  PerfectPlayer
+//*********************************************************************
+
+ // Places its ships like a GoodPlayer.  Whenever few enough fleet layouts
+ // agree with its shots it fires the shot that minimizes the expected
+ // number of shots to finish; before that it attacks like an OptimalPlayer.
+ class PerfectPlayer : public GoodPlayer
+ {
+ public:
+     PerfectPlayer(string nm, const Game& g);
+     virtual Point recommendAttack();
+     virtual void recommendAttacks(Point* shots, int k);
+     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+     virtual void reset();
+ private:
+     EndgameSolver solver;
+     DensityMap density;
+ };
+
+ PerfectPlayer::PerfectPlayer(string nm, const Game& g)
+     : GoodPlayer(nm, g), solver(g), density(g)
+ {}
+
+ Point PerfectPlayer::recommendAttack()
+ {
+     Point shot;
+     double expectedShots;
+     if (solver.solve(shot, expectedShots))
+         return shot;
+     return density.best();
+ }
+
+ void PerfectPlayer::recommendAttacks(Point* shots, int k)
+ {
+     //the solver plans one shot at a time, so a salvo goes by density
+     if (k == 1)
+         shots[0] = recommendAttack();
+     else
+         density.best(shots, k);
+ }
+
+ void PerfectPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+ {
+     if (!validShot)
+         return;
+     solver.record(p, shotHit, shipDestroyed, shipId);
+     density.record(p, shotHit, shipDestroyed, shipId);
+ }
+
+ void PerfectPlayer::reset()
+ {
+     GoodPlayer::reset();
+     solver.reset();
+     density.reset();
+ }
+
 //*********************************************************************
 //  createPlayer
 //*********************************************************************
@@ -723,7 +958,7 @@ HumanPlayer:: HumanPlayer(string nm, const Game& g) : Player(nm, g)
 Player* createPlayer(string type, string nm, const Game& g)
 {
     static string types[] = {
-        "human", "awful", "mediocre", "good"
+        "human", "awful", "mediocre", "good", "optimal", "montecarlo", "perfect"
     };
 
     int pos;
@@ -736,8 +971,15 @@ Player* createPlayer(string type, string nm, const Game& g)
     case 1:  return new AwfulPlayer(nm, g);
     case 2:  return new MediocrePlayer(nm, g);
     case 3:  return new GoodPlayer(nm, g);
+    case 4:  return new OptimalPlayer(nm, g);
+    case 5:  return createMonteCarloPlayer(nm, g);
+    case 6:  return new PerfectPlayer(nm, g);
     default: return nullptr;
     }
 }
 
-
+Player* createMonteCarloPlayer(string nm, const Game& g, int samplesPerMove,
+    double secondsPerMove, int nThreads, string bookPath)
+{
+    return new MonteCarloPlayer(nm, g, samplesPerMove, secondsPerMove, nThreads, bookPath);
+}
@@ -1,40 +1,75 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include "globals.h"
+#include "KnowledgeBoard.h"
 #include <string>
 
-class Point;
 class Board;
 class Game;
+class GameImpl;
 
 class Player
 {
 public:
-    Player(std::string nm, const Game& g)
-        : m_name(nm), m_game(g)
-    {}
+    Player(std::string nm, const Game& g);
 
     virtual ~Player() {}
 
-    std::string name() const { return m_name; }
+    const std::string& name() const { return m_name; }
     const Game& game() const { return m_game; }
+    // What this player has learned about the opponent's board so far, kept
+    // up to date by the Game
+    const KnowledgeBoard& knowledge() const { return m_knowledge; }
 
     virtual bool isHuman() const { return false; }
 
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
+    // The k shots of a salvo turn, fired together before any result comes
+    // back, written to shots.  By default, recommendAttack k times; players
+    // whose recommendAttack would repeat itself until told a result
+    // override this.
+    virtual void recommendAttacks(Point* shots, int k);
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+    // Get ready for another game of the same Game, keeping whatever memory
+    // the player already has: draw a new seed from the game and forget the
+    // last game, ending up just as a newly created player would.  Overrides
+    // call their base class's version first.
+    virtual void reset();
     // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
 
+protected:
+    // Draws from this player's own generator, seeded from the game
+    int randInt(int limit) { return m_rng.randInt(limit); }
+    Point randomPoint();
+    Rng& rng() { return m_rng; }
+
 private:
+    friend class GameImpl;
+
     std::string m_name;
     const Game& m_game;
+    Rng m_rng;
+    KnowledgeBoard m_knowledge;
 };
 
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+// A player that fires where ships lie in the most sampled fleet layouts
+// consistent with its shots ("montecarlo" to createPlayer, with the default
+// settings).  Each move makes up to samplesPerMove sampling attempts over
+// nThreads threads (0 means one per hardware thread) and, if secondsPerMove
+// is positive, stops when that time is up.  Its first shots come from the
+// opening book in the file at bookPath, or with no path from
+// OpeningBook::standard(), when that has a line for the game.  Without a
+// time limit a game still replays exactly from its seed and the same book.
+Player* createMonteCarloPlayer(std::string nm, const Game& g,
+    int samplesPerMove = 2000, double secondsPerMove = 0, int nThreads = 0,
+    std::string bookPath = "");
+
 #endif // PLAYER_INCLUDED
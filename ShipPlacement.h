@@ -0,0 +1,74 @@
+#ifndef SHIPPLACEMENT_INCLUDED
+#define SHIPPLACEMENT_INCLUDED
+
+// Where a ship of a given length can lie on a board of rows x cols cells,
+// the cells numbered row by row.  The fleet placer, the layout sampler and
+// the endgame solver all list placements this way and differ only in which
+// of them they keep.
+
+// A placement of a ship: its first cell and the index distance between
+// consecutive cells (1 across, the number of columns down)
+struct Placement
+{
+    Placement() : start(-1), step(0) {}
+    Placement(int s, int st) : start(s), step(st) {}
+    int start;
+    int step;
+};
+
+// Call visit(p) for every placement p of a ship of length len that lies
+// on the board, by first cell in reading order and across before down at
+// each.  A one-cell ship is listed across only, since placed down it is
+// the same.  Stops and returns false as soon as visit returns false.
+template<typename Visit>
+bool forEachPlacement(int rows, int cols, int len, Visit visit)
+{
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < cols; c++)
+        {
+            if (c + len <= cols && !visit(Placement(r * cols + c, 1)))
+                return false;
+            if (len > 1 && r + len <= rows && !visit(Placement(r * cols + c, cols)))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Likewise for every placement on the board that covers cell, the ones
+// starting k cells before it for k = 0, 1, ... in turn, across before down
+template<typename Visit>
+bool forEachPlacementCovering(int rows, int cols, int len, int cell, Visit visit)
+{
+    int r = cell / cols;
+    int c = cell % cols;
+    for (int k = 0; k < len; k++)
+    {
+        if (c - k >= 0 && c - k + len <= cols && !visit(Placement(cell - k, 1)))
+            return false;
+        if (len > 1 && r - k >= 0 && r - k + len <= rows && !visit(Placement(cell - k * cols, cols)))
+            return false;
+    }
+    return true;
+}
+
+// The number of placements forEachPlacement lists, and the k-th of them
+// counting every placement across before any placed down, for drawing one
+// uniformly without listing them
+inline int countPlacements(int rows, int cols, int len)
+{
+    int across = (len <= cols ? rows * (cols - len + 1) : 0);
+    int down = (len > 1 && len <= rows ? (rows - len + 1) * cols : 0);
+    return across + down;
+}
+
+inline Placement placementAt(int rows, int cols, int len, int k)
+{
+    int across = (len <= cols ? rows * (cols - len + 1) : 0);
+    if (k < across)
+        return Placement(k / (cols - len + 1) * cols + k % (cols - len + 1), 1);
+    return Placement(k - across, cols);
+}
+
+#endif // SHIPPLACEMENT_INCLUDED
@@ -0,0 +1,316 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "GameObserver.h"
+#include "Board.h"
+#include "LayoutSampler.h"
+#include "LockstepEngine.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Counts the shots each player fires
+class ShotCounter : public GameObserver
+{
+public:
+    ShotCounter(const Player* p1) : m_p1(p1), m_shots1(0), m_shots2(0) {}
+    virtual void shotFired(const Player& attacker, const Player& /* defender */,
+        const Board& /* b */, Point /* p */, bool /* validShot */,
+        bool /* shotHit */, bool /* shipDestroyed */, int /* shipId */)
+    {
+        if (&attacker == m_p1)
+            m_shots1++;
+        else
+            m_shots2++;
+    }
+    void reset() { m_shots1 = 0; m_shots2 = 0; }
+    long long shots1() const { return m_shots1; }
+    long long shots2() const { return m_shots2; }
+private:
+    const Player* m_p1;
+    long long m_shots1;
+    long long m_shots2;
+};
+
+unsigned long long gameSeed(unsigned long long tournamentSeed, int k)
+{
+    return mixSeed(tournamentSeed + k);
+}
+
+int playSeededGame(int nRows, int nCols, bool (*addShips)(Game&),
+    string type1, string type2, unsigned long long seed, bool type1First,
+    ostream* out, long long* shots1, long long* shots2)
+{
+    Game g(nRows, nCols, seed);
+    if (!addShips(g))
+        return 0;
+    // The first mover is created first, so it always gets the game's first
+    // player seed no matter which type it is
+    Player* p1 = nullptr;
+    Player* p2 = nullptr;
+    if (type1First)
+    {
+        p1 = createPlayer(type1, "Player 1", g);
+        p2 = createPlayer(type2, "Player 2", g);
+    }
+    else
+    {
+        p2 = createPlayer(type2, "Player 2", g);
+        p1 = createPlayer(type1, "Player 1", g);
+    }
+    int result = 0;
+    if (p1 != nullptr && p2 != nullptr)
+    {
+        ShotCounter counter(p1);
+        if (shots1 != nullptr || shots2 != nullptr)
+            g.addObserver(&counter);
+        Player* winner = (type1First ?
+            g.play(p1, p2, out) : g.play(p2, p1, out));
+        if (shots1 != nullptr)
+            *shots1 = counter.shots1();
+        if (shots2 != nullptr)
+            *shots2 = counter.shots2();
+        if (winner == p1)
+            result = 1;
+        else if (winner == p2)
+            result = 2;
+    }
+    delete p1;
+    delete p2;
+    return result;
+}
+
+// One worker's totals, folded into the tournament's once it finishes
+struct Tally
+{
+    Tally() : wins1(0), wins2(0), none(0), shots1(0), shots2(0), longest(0) {}
+    void add(int k, int nGames, int winner, long long gameShots1, long long gameShots2)
+    {
+        if (winner == 1)
+            wins1++;
+        else if (winner == 2)
+            wins2++;
+        else
+            none++;
+        shots1 += gameShots1;
+        shots2 += gameShots2;
+        long long packed = ((gameShots1 + gameShots2) << 32) | (nGames - k);
+        if (packed > longest)
+            longest = packed;
+    }
+    int wins1;
+    int wins2;
+    int none;
+    long long shots1;
+    long long shots2;
+    long long longest;      // packed as in Totals
+};
+
+// A tournament's totals, which its workers add to concurrently
+struct Totals
+{
+    Totals() : p1Wins(0), p2Wins(0), unfinished(0), p1Shots(0), p2Shots(0), longest(0) {}
+    void add(const Tally& t)
+    {
+        p1Wins += t.wins1;
+        p2Wins += t.wins2;
+        unfinished += t.none;
+        p1Shots += t.shots1;
+        p2Shots += t.shots2;
+        long long seen = longest;
+        while (t.longest > seen && !longest.compare_exchange_weak(seen, t.longest))
+            ;
+    }
+    void report(int nGames, TournamentResult& result) const
+    {
+        result.games = nGames;
+        result.p1Wins = p1Wins;
+        result.p2Wins = p2Wins;
+        result.unfinished = unfinished;
+        result.p1Shots = p1Shots;
+        result.p2Shots = p2Shots;
+        result.longestGameShots = longest >> 32;
+        if (result.longestGameShots > 0)
+            result.longestGame = nGames - static_cast<int>(longest & 0xFFFFFFFF);
+    }
+    atomic<int> p1Wins;
+    atomic<int> p2Wins;
+    atomic<int> unfinished;
+    atomic<long long> p1Shots;
+    atomic<long long> p2Shots;
+    // longest game packed as (shots << 32) | (nGames - k) so that a single
+    // atomic max keeps the lowest-numbered of equally long games
+    atomic<long long> longest;
+};
+
+// The number of threads to spread nGames games over when asked for nThreads
+int workerCount(int nGames, int nThreads)
+{
+    if (nThreads <= 0)
+        nThreads = thread::hardware_concurrency();
+    if (nThreads <= 0)
+        nThreads = 1;
+    if (nThreads > nGames)
+        nThreads = nGames;
+    return nThreads;
+}
+
+// Run worker on nThreads threads, this one included, and wait for them all.
+// Players that sample on threads of their own share the machine between
+// the workers instead of each starting one thread per core.
+template<typename Worker>
+void runWorkers(int nThreads, Worker worker)
+{
+    int hardware = thread::hardware_concurrency();
+    int share = max(1, hardware / nThreads);
+    auto limited = [&]()
+    {
+        LayoutSampler::limitThreads(share);
+        worker();
+    };
+    vector<thread> pool;
+    for (int t = 1; t < nThreads; t++)
+        pool.push_back(thread(limited));
+    int before = LayoutSampler::limitThreads(share);
+    worker();
+    LayoutSampler::limitThreads(before);
+    for (size_t t = 0; t < pool.size(); t++)
+        pool[t].join();
+}
+
+TournamentResult runTournament(int nRows, int nCols, bool (*addShips)(Game&),
+    string type1, string type2, int nGames, int nThreads,
+    unsigned long long seed)
+{
+    TournamentResult result;
+    if (seed == 0)
+        seed = randomSeed();
+    result.seed = seed;
+    if (nGames <= 0 || type1 == "human" || type2 == "human")
+        return result;
+
+    // Workers claim game numbers from a shared counter and keep their own
+    // tallies, which are folded into the totals once when they finish
+    atomic<int> nextGame(1);
+    Totals totals;
+
+    auto worker = [&]()
+    {
+        // Each worker sets up one game and its two players and replays them
+        // for every game it claims, resetting them in between, which leaves
+        // the same state that building them for the game's seed would
+        Game g(nRows, nCols, seed);
+        bool ready = addShips(g);
+        Player* p1 = (ready ? createPlayer(type1, "Player 1", g) : nullptr);
+        Player* p2 = (ready ? createPlayer(type2, "Player 2", g) : nullptr);
+        ShotCounter counter(p1);
+        g.addObserver(&counter);
+        Tally tally;
+        for (int k = nextGame++; k <= nGames; k = nextGame++)
+        {
+            long long gameShots1 = 0;
+            long long gameShots2 = 0;
+            int winner = 0;
+            if (p1 != nullptr && p2 != nullptr)
+            {
+                // as in playSeededGame, the first mover takes the first seed
+                bool type1First = (k % 2 == 1);
+                g.reseed(gameSeed(seed, k));
+                (type1First ? p1 : p2)->reset();
+                (type1First ? p2 : p1)->reset();
+                counter.reset();
+                Player* w = (type1First ? g.play(p1, p2, nullptr) : g.play(p2, p1, nullptr));
+                gameShots1 = counter.shots1();
+                gameShots2 = counter.shots2();
+                if (w == p1)
+                    winner = 1;
+                else if (w == p2)
+                    winner = 2;
+            }
+            tally.add(k, nGames, winner, gameShots1, gameShots2);
+        }
+        delete p1;
+        delete p2;
+        totals.add(tally);
+    };
+
+    runWorkers(workerCount(nGames, nThreads), worker);
+    totals.report(nGames, result);
+    return result;
+}
+
+// Hands a worker's LockstepEngine the games it claims from the shared
+// counter, seeded as runTournament seeds them, and tallies their results
+class TournamentSchedule : public LockstepSchedule
+{
+public:
+    TournamentSchedule(Game& g, unsigned long long seed, int nGames,
+            atomic<int>& nextGame, Tally& tally)
+        : m_game(g), m_seed(seed), m_nGames(nGames), m_nextGame(nextGame), m_tally(tally)
+    {}
+    virtual bool nextGame(LockstepGame& game)
+    {
+        int k = m_nextGame++;
+        if (k > m_nGames)
+            return false;
+        game.id = k;
+        game.p1First = (k % 2 == 1);
+        // the first mover's player is reset first and takes the first seed
+        m_game.reseed(gameSeed(m_seed, k));
+        unsigned long long first = m_game.nextSeed();
+        unsigned long long second = m_game.nextSeed();
+        game.seed1 = (game.p1First ? first : second);
+        game.seed2 = (game.p1First ? second : first);
+        return true;
+    }
+    virtual void gameOver(int id, int winner, long long shots1, long long shots2)
+    {
+        m_tally.add(id, m_nGames, winner, shots1, shots2);
+    }
+private:
+    Game& m_game;
+    unsigned long long m_seed;
+    int m_nGames;
+    atomic<int>& m_nextGame;
+    Tally& m_tally;
+};
+
+TournamentResult runLockstepTournament(int nRows, int nCols, bool (*addShips)(Game&),
+    string type1, string type2, int nGames, int nThreads,
+    unsigned long long seed, int lanes)
+{
+    if (seed == 0)
+        seed = randomSeed();
+    LockstepEngine::Strategy s1;
+    LockstepEngine::Strategy s2;
+    if (nGames <= 0 || !LockstepEngine::strategyFor(type1, s1) ||
+            !LockstepEngine::strategyFor(type2, s2))
+        return runTournament(nRows, nCols, addShips, type1, type2, nGames, nThreads, seed);
+    Game probe(nRows, nCols, seed);
+    if (!addShips(probe) || !LockstepEngine::supports(probe))
+        return runTournament(nRows, nCols, addShips, type1, type2, nGames, nThreads, seed);
+
+    TournamentResult result;
+    result.seed = seed;
+    atomic<int> nextGame(1);
+    Totals totals;
+
+    auto worker = [&]()
+    {
+        Game g(nRows, nCols, seed);
+        addShips(g);
+        LockstepEngine engine(g, s1, s2, lanes);
+        Tally tally;
+        TournamentSchedule schedule(g, seed, nGames, nextGame, tally);
+        engine.run(schedule);
+        totals.add(tally);
+    };
+
+    runWorkers(workerCount(nGames, nThreads), worker);
+    totals.report(nGames, result);
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include <string>
+#include <iosfwd>
+
+class Game;
+class Player;
+
+// Totals from a tournament between two player types
+struct TournamentResult
+{
+    TournamentResult()
+        : games(0), p1Wins(0), p2Wins(0), unfinished(0), p1Shots(0), p2Shots(0),
+          seed(0), longestGame(0), longestGameShots(0)
+    {}
+    int games;
+    int p1Wins;
+    int p2Wins;
+    int unfinished;     // games where a player could not place its ships
+    long long p1Shots;
+    long long p2Shots;
+    unsigned long long seed;    // base seed; see gameSeed()
+    int longestGame;            // game number with the most shots fired
+    long long longestGameShots;
+};
+
+// The seed the Game numbered k (1-based) of a tournament was created with
+unsigned long long gameSeed(unsigned long long tournamentSeed, int k);
+
+// Play one game with the given seed, type1 moving first if type1First.
+// Reporting goes to out (null for silent).  A game depends only on its seed
+// and the types in move order, so a tournament game replays exactly from
+// gameSeed() and its first and second movers.  Returns 1 or 2 for the winning type,
+// or 0 if the game could not be played.
+int playSeededGame(int nRows, int nCols, bool (*addShips)(Game&),
+    std::string type1, std::string type2, unsigned long long seed,
+    bool type1First, std::ostream* out, long long* shots1 = nullptr,
+    long long* shots2 = nullptr);
+
+// Play nGames silent games between a player of type1 and one of type2 (as
+// accepted by createPlayer; "human" is not allowed) on an nRows x nCols board
+// whose fleet is added by addShips.  type1 moves first in odd-numbered games
+// and type2 in even-numbered ones.  Games are spread over nThreads worker
+// threads; 0 means one per hardware thread.  Game k is seeded with
+// gameSeed(seed, k), so results do not depend on the number of threads;
+// a seed of 0 picks a random one.  A Monte Carlo player in a worker samples
+// on at most its worker's share of the hardware threads.
+TournamentResult runTournament(int nRows, int nCols, bool (*addShips)(Game&),
+    std::string type1, std::string type2, int nGames, int nThreads = 0,
+    unsigned long long seed = 0);
+
+// runTournament's games and results, played by LockstepEngines (one per
+// worker thread, each with the given number of lanes) when both types have
+// a LockstepEngine strategy and the board size is supported, and by
+// runTournament otherwise
+TournamentResult runLockstepTournament(int nRows, int nCols, bool (*addShips)(Game&),
+    std::string type1, std::string type2, int nGames, int nThreads = 0,
+    unsigned long long seed = 0, int lanes = 16);
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,842 @@
+// Throughput benchmarks for the board, the players and whole games.
+//
+// Build from the repository root together with every engine source, e.g.
+//     g++ -std=c++17 -O2 -pthread -I. bench/Benchmark.cpp
+//         $(ls *.cpp | grep -v main.cpp) -o battleship-bench
+// and run
+//     battleship-bench [--out results.json] [--baseline bench/baseline.json]
+//                      [--tolerance 0.10] [--filter substring]
+//     battleship-bench --audit-allocations
+//     battleship-bench --audit-salvos
+//     battleship-bench --audit-snapshots
+// Results are written as JSON.  With --baseline, every benchmark that is
+// slower than the stored figure by more than the tolerance is reported and
+// the exit status is 1.  --audit-allocations instead plays bot games, the
+// Monte Carlo and perfect players' games twice over, and exits with status
+// 1 if any turn allocated heap memory (the second time, for those two); --audit-salvos if
+// any salvo fired at a cell twice; --audit-snapshots if a board restores a
+// snapshot of another fleet.
+
+#include "Board.h"
+#include "Game.h"
+#include "GameObserver.h"
+#include "Player.h"
+#include "PlacementKernel.h"
+#include "Tournament.h"
+#include "globals.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Every heap allocation made by a thread, counted for --audit-allocations
+thread_local long long allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+bool addStandardShips(Game& g)
+{
+    return g.addShip(5, 'A', "aircraft carrier") &&
+        g.addShip(4, 'B', "battleship") &&
+        g.addShip(3, 'D', "destroyer") &&
+        g.addShip(3, 'S', "submarine") &&
+        g.addShip(2, 'P', "patrol boat");
+}
+
+struct Result
+{
+    string name;
+    double nsPerOp;
+    long long ops;
+};
+
+vector<Result> results;
+string filter;
+
+double now()
+{
+    return chrono::duration<double>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time body(n), which performs n operations and returns how many it really
+// did, doubling n until a run lasts long enough to be measured reliably
+template<typename Body>
+void measure(string name, Body body)
+{
+    if (!filter.empty() && name.find(filter) == string::npos)
+        return;
+    const double minSeconds = 0.25;
+    long long n = 1;
+    for (;;)
+    {
+        double start = now();
+        long long done = body(n);
+        double elapsed = now() - start;
+        if (elapsed >= minSeconds || n >= (1LL << 40))
+        {
+            Result r;
+            r.name = name;
+            r.ops = done;
+            r.nsPerOp = (done > 0 ? elapsed * 1e9 / done : 0);
+            results.push_back(r);
+            cerr << name << ": " << r.nsPerOp << " ns/op" << endl;
+            return;
+        }
+        n *= 2;
+    }
+}
+
+// Keeps the optimizer from discarding benchmark results
+volatile long long sink;
+
+//*********************************************************************
+//  Board
+//*********************************************************************
+
+void benchBoard(int nRows, int nCols)
+{
+    string size = to_string(nRows) + "x" + to_string(nCols);
+    Game g(nRows, nCols, 1);
+    addStandardShips(g);
+
+    measure("board/" + size + "/placeShip+unplaceShip", [&](long long n) {
+        Board b(g);
+        long long done = 0;
+        for (long long k = 0; k < n; k++)
+        {
+            Point p(k % nRows, 0);
+            int shipId = k % g.nShips();
+            done += b.placeShip(p, shipId, HORIZONTAL);
+            b.unplaceShip(p, shipId, HORIZONTAL);
+        }
+        sink = done;
+        return n;
+    });
+
+    // Every cell of a fully placed board, in row-major order, so each pass
+    // covers the whole hit/miss/sunk logic
+    measure("board/" + size + "/attack", [&](long long n) {
+        long long done = 0;
+        bool hit;
+        bool destroyed;
+        int shipId;
+        while (done < n)
+        {
+            Board b(g);
+            for (int s = 0; s < g.nShips(); s++)
+                b.placeShip(Point(s, 0), s, HORIZONTAL);
+            for (int r = 0; r < nRows && done < n; r++)
+                for (int c = 0; c < nCols && done < n; c++, done++)
+                    b.attack(Point(r, c), hit, destroyed, shipId);
+        }
+        return done;
+    });
+
+    // The same shots fired as salvos of five, timed per shot
+    measure("board/" + size + "/attackBatch", [&](long long n) {
+        long long done = 0;
+        Point shots[5];
+        ShotResult results[5];
+        while (done < n)
+        {
+            Board b(g);
+            for (int s = 0; s < g.nShips(); s++)
+                b.placeShip(Point(s, 0), s, HORIZONTAL);
+            for (int cell = 0; cell < nRows * nCols && done < n; )
+            {
+                int k = 0;
+                for (; k < 5 && cell < nRows * nCols; k++, cell++)
+                    shots[k] = Point(cell / nCols, cell % nCols);
+                b.attackBatch(shots, k, results);
+                done += k;
+            }
+        }
+        return done;
+    });
+
+    measure("board/" + size + "/allShipsDestroyed", [&](long long n) {
+        Board b(g);
+        for (int s = 0; s < g.nShips(); s++)
+            b.placeShip(Point(s, 0), s, HORIZONTAL);
+        long long count = 0;
+        for (long long k = 0; k < n; k++)
+            count += b.allShipsDestroyed();
+        sink = count;
+        return n;
+    });
+
+    // What a search player does per hypothetical shot
+    measure("board/" + size + "/attack+popUndo", [&](long long n) {
+        Board b(g);
+        for (int s = 0; s < g.nShips(); s++)
+            b.placeShip(Point(s, 0), s, HORIZONTAL);
+        bool hit;
+        bool destroyed;
+        int shipId;
+        long long count = 0;
+        for (long long k = 0; k < n; k++)
+        {
+            b.pushUndo();
+            count += b.attack(Point(k % nRows, k / nRows % nCols), hit, destroyed, shipId);
+            b.popUndo();
+        }
+        sink = count;
+        return n;
+    });
+
+    measure("board/" + size + "/save+restore", [&](long long n) {
+        Board b(g);
+        for (int s = 0; s < g.nShips(); s++)
+            b.placeShip(Point(s, 0), s, HORIZONTAL);
+        BoardSnapshot snapshot;
+        long long count = 0;
+        for (long long k = 0; k < n; k++)
+        {
+            b.save(snapshot);
+            count += b.restore(snapshot);
+        }
+        sink = count;
+        return n;
+    });
+
+    measure("board/" + size + "/block+unblock", [&](long long n) {
+        Board b(g);
+        for (long long k = 0; k < n; k++)
+        {
+            b.block();
+            b.unblock();
+        }
+        return n;
+    });
+
+    // Rendering into a stream that is emptied each time, so only the
+    // formatting is timed
+    measure("board/" + size + "/display", [&](long long n) {
+        Board b(g);
+        for (int s = 0; s < g.nShips(); s++)
+            b.placeShip(Point(s, 0), s, HORIZONTAL);
+        ostringstream out;
+        for (long long k = 0; k < n; k++)
+        {
+            out.str("");
+            b.display(false, out);
+        }
+        return n;
+    });
+
+    // One shot shown in place and then taken back, as a spectator sees it
+    measure("board/" + size + "/attack+redisplay", [&](long long n) {
+        Board b(g);
+        for (int s = 0; s < g.nShips(); s++)
+            b.placeShip(Point(s, 0), s, HORIZONTAL);
+        ostringstream out;
+        b.display(false, out);
+        bool hit;
+        bool destroyed;
+        int shipId;
+        for (long long k = 0; k < n; k++)
+        {
+            out.str("");
+            b.pushUndo();
+            b.attack(Point(k % nRows, k / nRows % nCols), hit, destroyed, shipId);
+            b.redisplay(false, out);
+            b.popUndo();
+        }
+        return n;
+    });
+}
+
+//*********************************************************************
+//  Placement kernel
+//*********************************************************************
+
+// A full density map for the standard fleet on a 10x10 board part way
+// through a game, on every instruction set compiled in
+void benchKernel()
+{
+    const int lengths[] = { 5, 4, 3, 2 };
+    const int multipliers[] = { 1, 1, 2, 1 };
+    vector<unsigned char> blocked(100, 0);
+    vector<unsigned char> hits(100, 0);
+    Rng rng(4);
+    for (int k = 0; k < 30; k++)
+        blocked[rng.randInt(100)] = 1;
+    for (int k = 0; k < 3; k++)
+        hits[rng.randInt(100)] = 1;
+    for (int path = PlacementKernel::SCALAR; path < PlacementKernel::BEST; path++)
+    {
+        PlacementKernel kernel(10, 10, PlacementKernel::Path(path));
+        if (kernel.path() != path)
+            continue;
+        measure(string("kernel/10x10/") + PlacementKernel::pathName(kernel.path()),
+                [&](long long n) {
+            vector<int> density(100);
+            for (long long k = 0; k < n; k++)
+            {
+                fill(density.begin(), density.end(), 0);
+                kernel.setBoard(&blocked[0], &hits[0]);
+                for (int i = 0; i < 4; i++)
+                    kernel.accumulate(lengths[i], 64, multipliers[i], &density[0]);
+            }
+            sink = density[0];
+            return n;
+        });
+    }
+}
+
+//*********************************************************************
+//  Players
+//*********************************************************************
+
+const char* const playerTypes[] = { "awful", "mediocre", "good", "optimal", "montecarlo", "perfect" };
+
+void benchPlaceShips()
+{
+    for (const char* type : playerTypes)
+    {
+        measure(string("player/") + type + "/placeShips", [&](long long n) {
+            Game g(10, 10, 2);
+            addStandardShips(g);
+            long long placed = 0;
+            for (long long k = 0; k < n; k++)
+            {
+                Board b(g);
+                Player* p = createPlayer(type, "bench", g);
+                placed += p->placeShips(b);
+                delete p;
+            }
+            sink = placed;
+            return n;
+        });
+    }
+}
+
+// recommendAttack latency split by how much of the board has been shot at:
+// opening (< 1/3), middle game and endgame (> 2/3)
+void benchRecommendAttack()
+{
+    const char* phases[] = { "opening", "middle", "endgame" };
+    for (const char* type : playerTypes)
+    {
+        double seconds[3] = { 0, 0, 0 };
+        long long calls[3] = { 0, 0, 0 };
+        double start = now();
+        for (unsigned long long seed = 1; now() - start < 0.5; seed++)
+        {
+            Game g(10, 10, seed);
+            addStandardShips(g);
+            Board b(g);
+            Player* placer = createPlayer("good", "placer", g);
+            placer->placeShips(b);
+            Player* p = createPlayer(type, "bench", g);
+            int cells = g.rows() * g.cols();
+            for (int shot = 0; shot < cells && !b.allShipsDestroyed(); shot++)
+            {
+                int phase = 3 * shot / cells;
+                double t0 = now();
+                Point target = p->recommendAttack();
+                seconds[phase] += now() - t0;
+                calls[phase]++;
+                bool hit = false;
+                bool destroyed = false;
+                int shipId = -1;
+                bool valid = b.attack(target, hit, destroyed, shipId);
+                g.reportAttack(p, target, valid, hit, destroyed, shipId);
+            }
+            delete p;
+            delete placer;
+        }
+        for (int phase = 0; phase < 3; phase++)
+        {
+            string name = string("player/") + type + "/recommendAttack/" + phases[phase];
+            if (!filter.empty() && name.find(filter) == string::npos)
+                continue;
+            Result r;
+            r.name = name;
+            r.ops = calls[phase];
+            r.nsPerOp = (calls[phase] > 0 ? seconds[phase] * 1e9 / calls[phase] : 0);
+            results.push_back(r);
+            cerr << name << ": " << r.nsPerOp << " ns/op" << endl;
+        }
+    }
+}
+
+//*********************************************************************
+//  Games and random numbers
+//*********************************************************************
+
+void benchGames()
+{
+    const char* pairs[][2] = {
+        { "awful", "mediocre" }, { "mediocre", "good" }, { "good", "good" },
+        { "good", "optimal" }, { "optimal", "montecarlo" }
+    };
+    for (auto& pair : pairs)
+    {
+        string name = string("game/") + pair[0] + "-vs-" + pair[1];
+        measure(name, [&](long long n) {
+            long long played = 0;
+            for (long long k = 1; k <= n; k++)
+            {
+                Game g(10, 10, k);
+                addStandardShips(g);
+                Player* p1 = createPlayer(pair[0], "one", g);
+                Player* p2 = createPlayer(pair[1], "two", g);
+                played += (g.play(p1, p2, nullptr) != nullptr);
+                delete p1;
+                delete p2;
+            }
+            sink = played;
+            return n;
+        });
+    }
+}
+
+// Whole single-threaded tournaments, object by object and in lockstep
+void benchTournaments()
+{
+    const char* pairs[][2] = {
+        { "awful", "awful" }, { "awful", "optimal" }, { "optimal", "optimal" }
+    };
+    for (auto& pair : pairs)
+    {
+        string suffix = string(pair[0]) + "-vs-" + pair[1];
+        measure("tournament/" + suffix, [&](long long n) {
+            sink = runTournament(10, 10, addStandardShips, pair[0], pair[1], n, 1, 7).p1Wins;
+            return n;
+        });
+        measure("lockstep/" + suffix, [&](long long n) {
+            sink = runLockstepTournament(10, 10, addStandardShips, pair[0], pair[1], n, 1, 7).p1Wins;
+            return n;
+        });
+    }
+}
+
+void benchRng()
+{
+    measure("rng/randInt", [&](long long n) {
+        Rng rng(3);
+        long long sum = 0;
+        for (long long k = 0; k < n; k++)
+            sum += rng.randInt(10);
+        sink = sum;
+        return n;
+    });
+}
+
+//*********************************************************************
+//  Allocation audit
+//*********************************************************************
+
+// Counts the turns during which anything was allocated
+class AllocationAudit : public GameObserver
+{
+public:
+    AllocationAudit() : turns(0), allocatingTurns(0), m_before(0) {}
+    void clear()
+    {
+        turns = 0;
+        allocatingTurns = 0;
+    }
+    virtual void turnStarted(const Player&, const Player&, const Board&)
+    {
+        m_before = allocations;
+    }
+    virtual void turnEnded(const Player&, int)
+    {
+        turns++;
+        if (allocations != m_before)
+            allocatingTurns++;
+    }
+    long long turns;
+    long long allocatingTurns;
+private:
+    long long m_before;
+};
+
+// Swallows whatever is written to it, without allocating
+class NullBuffer : public streambuf
+{
+protected:
+    virtual int overflow(int c) { return c; }
+    virtual streamsize xsputn(const char*, streamsize n) { return n; }
+};
+
+// A player for the allocation audit: a Monte Carlo player samples on two
+// threads, so that the thread pool is audited even on one core
+Player* createAuditPlayer(string type, string nm, const Game& g)
+{
+    if (type == "montecarlo")
+        return createMonteCarloPlayer(nm, g, 2000, 0, 2);
+    return createPlayer(type, nm, g);
+}
+
+// Play nGames games between a player of type1 and one of type2 on an
+// n x n board, silently (mode 0), with commentary sent nowhere (mode 1) or
+// as salvo games (mode 2), and report how many turns allocated.  With
+// replay, the same two players play every game twice, reset in between as
+// a tournament resets them, and only the second time through is counted:
+// whatever scratch space they keep has grown to fit those games by then.
+// Without, each game gets new players.
+long long auditGames(string type1, string type2, int n, int mode, int nGames, bool replay)
+{
+    NullBuffer nullBuffer;
+    ostream nowhere(&nullBuffer);
+    ostream* out = (mode == 1 ? &nowhere : nullptr);
+    AllocationAudit audit;
+    if (replay)
+    {
+        Game g(n, n, 1);
+        addStandardShips(g);
+        if (mode == 2)
+            g.setSalvo(Game::ONE_PER_SHIP);
+        g.addObserver(&audit);
+        Player* p1 = createAuditPlayer(type1, "one", g);
+        Player* p2 = createAuditPlayer(type2, "two", g);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            audit.clear();
+            for (unsigned long long seed = 1; seed <= static_cast<unsigned long long>(nGames); seed++)
+            {
+                g.reseed(seed);
+                p1->reset();
+                p2->reset();
+                g.play(p1, p2, out);
+            }
+        }
+        delete p1;
+        delete p2;
+    }
+    else
+    {
+        for (unsigned long long seed = 1; seed <= static_cast<unsigned long long>(nGames); seed++)
+        {
+            Game g(n, n, seed);
+            addStandardShips(g);
+            if (mode == 2)
+                g.setSalvo(Game::ONE_PER_SHIP);
+            g.addObserver(&audit);
+            Player* p1 = createAuditPlayer(type1, "one", g);
+            Player* p2 = createAuditPlayer(type2, "two", g);
+            g.play(p1, p2, out);
+            delete p1;
+            delete p2;
+        }
+    }
+    cerr << type1 << "-vs-" << type2 << " on " << n << "x" << n
+        << (mode == 1 ? " with commentary" : mode == 2 ? " in salvo" : "")
+        << (replay ? ", replayed" : "")
+        << ": " << audit.allocatingTurns << " of " << audit.turns
+        << " turns allocated" << endl;
+    return audit.allocatingTurns;
+}
+
+// Play games between the computer players on the fixed-size 10x10 board
+// and on a 12x12 one, which takes the general board, and report any turn
+// that allocated.  The players that keep no per-move scratch space must
+// not allocate in any game; the Monte Carlo and perfect players, whose
+// samplers and solvers keep theirs from move to move and game to game,
+// must not allocate in games they have played before.  Returns the number
+// of turns that allocated.
+long long auditAllocations()
+{
+    const char* types[] = { "awful", "mediocre", "good", "optimal" };
+    const char* scratchTypes[] = { "montecarlo", "perfect" };
+    const int sizes[] = { 10, 12 };
+    long long failures = 0;
+    for (int n : sizes)
+    {
+        for (const char* type1 : types)
+        {
+            for (const char* type2 : types)
+            {
+                for (int mode = 0; mode < 3; mode++)
+                    failures += auditGames(type1, type2, n, mode, 50, false);
+            }
+        }
+        for (const char* type1 : scratchTypes)
+        {
+            for (const char* type2 : scratchTypes)
+            {
+                for (int mode = 0; mode < 3; mode++)
+                    failures += auditGames(type1, type2, n, mode, 10, true);
+            }
+        }
+    }
+    return failures;
+}
+
+//*********************************************************************
+//  Salvo audit
+//*********************************************************************
+
+// Counts the shots that repeat a cell fired at earlier in the same turn
+class SalvoAudit : public GameObserver
+{
+public:
+    SalvoAudit() : shots(0), repeats(0) {}
+    virtual void turnStarted(const Player&, const Player&, const Board&)
+    {
+        m_turn.clear();
+    }
+    virtual void shotFired(const Player&, const Player&, const Board&, Point p,
+        bool, bool, bool, int)
+    {
+        shots++;
+        for (size_t k = 0; k < m_turn.size(); k++)
+        {
+            if (m_turn[k].r == p.r && m_turn[k].c == p.c)
+            {
+                repeats++;
+                break;
+            }
+        }
+        m_turn.push_back(p);
+    }
+    long long shots;
+    long long repeats;
+private:
+    vector<Point> m_turn;
+};
+
+// Play salvo games, one shot per ship afloat and seven shots a turn, with
+// every computer player against itself and report any shot that
+// repeats a cell of the same salvo.  Returns the number of such shots.
+long long auditSalvos()
+{
+    long long failures = 0;
+    for (const char* type : playerTypes)
+    {
+        for (int salvo : { int(Game::ONE_PER_SHIP), 7 })
+        {
+            SalvoAudit audit;
+            for (unsigned long long seed = 1; seed <= 20; seed++)
+            {
+                Game g(10, 10, seed);
+                addStandardShips(g);
+                g.setSalvo(salvo);
+                g.addObserver(&audit);
+                Player* p1 = createPlayer(type, "one", g);
+                Player* p2 = createPlayer(type, "two", g);
+                g.play(p1, p2, nullptr);
+                delete p1;
+                delete p2;
+            }
+            cerr << type << "-vs-" << type << ", " << (salvo == Game::ONE_PER_SHIP ? "one per ship" : "7 shots")
+                << ": " << audit.repeats << " of " << audit.shots << " shots repeated a cell of their salvo" << endl;
+            failures += audit.repeats;
+        }
+    }
+    return failures;
+}
+
+//*********************************************************************
+//  Snapshot audit
+//*********************************************************************
+
+// Add ships of the given lengths to g
+void addFleet(Game& g, const vector<int>& lengths)
+{
+    for (size_t k = 0; k < lengths.size(); k++)
+        g.addShip(lengths[k], char('A' + k), string("ship ") + char('A' + k));
+}
+
+// Save a board of each fleet and restore it on a board of the same size
+// with each other fleet, which must succeed exactly when the ship lengths
+// agree.  The fleets fill the same number of snapshot words, so only the
+// lengths tell them apart.  Returns the number of wrong outcomes.
+long long auditSnapshots()
+{
+    const vector<vector<int> > fleets = {
+        { 5, 4, 3, 3, 2 }, { 2, 3, 3, 4, 5 }, { 5, 4, 3, 3, 3 }, { 5, 4, 3, 3, 2, 1 }
+    };
+    //a compile-time-sized board and a dynamically sized one
+    const int sizes[][2] = { { 10, 10 }, { 12, 9 } };
+    long long failures = 0;
+    for (const auto& size : sizes)
+    {
+        for (size_t from = 0; from < fleets.size(); from++)
+        {
+            Game saved(size[0], size[1], 1);
+            addFleet(saved, fleets[from]);
+            Board b(saved);
+            for (int id = 0; id < saved.nShips(); id++)
+                b.placeShip(Point(id, 0), id, HORIZONTAL);
+            BoardSnapshot snapshot;
+            b.save(snapshot);
+            for (size_t to = 0; to < fleets.size(); to++)
+            {
+                Game restored(size[0], size[1], 1);
+                addFleet(restored, fleets[to]);
+                Board other(restored);
+                bool expected = (fleets[from] == fleets[to]);
+                if (other.restore(snapshot) != expected)
+                {
+                    cerr << size[0] << "x" << size[1] << ": fleet " << from
+                        << (expected ? " not restored" : " restored") << " on fleet " << to << endl;
+                    failures++;
+                }
+            }
+        }
+    }
+    cerr << "snapshots: " << failures << " wrong restores" << endl;
+    return failures;
+}
+
+//*********************************************************************
+//  JSON output and baseline comparison
+//*********************************************************************
+
+string toJson()
+{
+    ostringstream out;
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        out << "    { \"name\": \"" << results[k].name << "\", \"ns_per_op\": "
+            << results[k].nsPerOp << ", \"ops\": " << results[k].ops << " }"
+            << (k + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// Read the name/ns_per_op pairs from a file written by toJson
+bool readBaseline(string path, vector<Result>& baseline)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    string line;
+    while (getline(in, line))
+    {
+        size_t name = line.find("\"name\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (name == string::npos || ns == string::npos)
+            continue;
+        name += 9;
+        Result r;
+        r.name = line.substr(name, line.find('"', name) - name);
+        r.nsPerOp = atof(line.c_str() + ns + 13);
+        r.ops = 0;
+        baseline.push_back(r);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    string outPath;
+    string baselinePath;
+    double tolerance = 0.10;
+    for (int k = 1; k < argc; k++)
+    {
+        string arg = argv[k];
+        if (arg == "--out" && k + 1 < argc)
+            outPath = argv[++k];
+        else if (arg == "--baseline" && k + 1 < argc)
+            baselinePath = argv[++k];
+        else if (arg == "--tolerance" && k + 1 < argc)
+            tolerance = atof(argv[++k]);
+        else if (arg == "--filter" && k + 1 < argc)
+            filter = argv[++k];
+        else if (arg == "--audit-allocations")
+            return auditAllocations() > 0 ? 1 : 0;
+        else if (arg == "--audit-salvos")
+            return auditSalvos() > 0 ? 1 : 0;
+        else if (arg == "--audit-snapshots")
+            return auditSnapshots() > 0 ? 1 : 0;
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--out file] [--baseline file]"
+                << " [--tolerance fraction] [--filter substring]" << endl
+                << "       " << argv[0] << " --audit-allocations" << endl
+                << "       " << argv[0] << " --audit-salvos" << endl
+                << "       " << argv[0] << " --audit-snapshots" << endl;
+            return 2;
+        }
+    }
+
+    benchRng();
+    benchBoard(10, 10);
+    benchBoard(100, 100);
+    benchKernel();
+    benchPlaceShips();
+    benchRecommendAttack();
+    benchGames();
+    benchTournaments();
+
+    string json = toJson();
+    if (outPath.empty())
+        cout << json;
+    else
+        ofstream(outPath) << json;
+
+    if (baselinePath.empty())
+        return 0;
+    vector<Result> baseline;
+    if (!readBaseline(baselinePath, baseline))
+    {
+        cerr << "Cannot read baseline " << baselinePath << endl;
+        return 2;
+    }
+    int regressions = 0;
+    for (size_t k = 0; k < results.size(); k++)
+    {
+        for (size_t j = 0; j < baseline.size(); j++)
+        {
+            if (baseline[j].name != results[k].name || baseline[j].nsPerOp <= 0)
+                continue;
+            double ratio = results[k].nsPerOp / baseline[j].nsPerOp;
+            if (ratio > 1 + tolerance)
+            {
+                cerr << "REGRESSION " << results[k].name << ": "
+                    << baseline[j].nsPerOp << " -> " << results[k].nsPerOp
+                    << " ns/op (" << (ratio - 1) * 100 << "% slower)" << endl;
+                regressions++;
+            }
+        }
+    }
+    return regressions > 0 ? 1 : 0;
+}
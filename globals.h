@@ -2,9 +2,11 @@
 #define GLOBALS_INCLUDED
 
 #include <random>
+#include <cstdint>
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+// Boards are sized at runtime; these only bound what a Game will accept
+const int MAXROWS = 1000;
+const int MAXCOLS = 1000;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,15 +21,92 @@ public:
     int c;
 };
 
-// Return a uniformly distributed random int from 0 to limit-1
-inline int randInt(int limit)
+// Scramble a seed (the splitmix64 finalizer) so that nearby inputs such as
+// seed+1, seed+2, ... give unrelated generator streams
+inline unsigned long long mixSeed(unsigned long long x)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    if (limit < 1)
-        limit = 1;
-    std::uniform_int_distribution<> distro(0, limit - 1);
-    return distro(generator);
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// A seedable random number source.  Every Game and Player owns one, so a
+// game is fully determined by the Game's seed and the players taking part.
+// The generator is xoshiro256**, and bounded draws use Lemire's
+// multiply-shift method, which needs no division in the common case.
+class Rng
+{
+public:
+    explicit Rng(unsigned long long seed = 0) { this->seed(seed); }
+
+    void seed(unsigned long long s)
+    {
+        // expand the seed with splitmix64 so the state is never all zero
+        for (int k = 0; k < 4; k++)
+        {
+            s += 0x9E3779B97F4A7C15ULL;
+            m_state[k] = mixSeed(s);
+        }
+    }
+
+    // Return 64 uniformly distributed random bits
+    std::uint64_t next()
+    {
+        std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+        std::uint64_t t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    // Return a uniformly distributed random int from 0 to limit-1
+    int randInt(int limit)
+    {
+        if (limit <= 1)
+            return 0;
+        std::uint32_t bound = limit;
+        std::uint64_t m = (next() >> 32) * bound;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < bound)
+        {
+            // reject the few values that would bias the result
+            std::uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold)
+            {
+                m = (next() >> 32) * bound;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<int>(m >> 32);
+    }
+
+    // Fill out[0..n-1] with uniformly distributed random ints from 0 to
+    // limit-1, the same values n calls to randInt would return
+    void fill(int* out, int n, int limit)
+    {
+        for (int k = 0; k < n; k++)
+            out[k] = randInt(limit);
+    }
+
+private:
+    std::uint64_t m_state[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// Return a seed drawn from the system's entropy source
+inline unsigned long long randomSeed()
+{
+    std::random_device rd;
+    return (static_cast<unsigned long long>(rd()) << 32) ^ rd();
 }
 
 #endif // GLOBALS_INCLUDED
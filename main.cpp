@@ -1,5 +1,7 @@
 #include "Game.h"
+#include "OpeningBook.h"
 #include "Player.h"
+#include "Tournament.h"
 #include <iostream>
 #include <string>
 
@@ -14,6 +16,35 @@ bool addStandardShips(Game& g)
         g.addShip(2, 'P', "patrol boat");
 }
 
+// Print which opening book a Monte Carlo player among the types opens
+// with, since a game replays exactly only with the same book
+void reportBook(string type1, string type2)
+{
+    if (type1 != "montecarlo" && type2 != "montecarlo")
+        return;
+    const OpeningBook& book = OpeningBook::standard();
+    if (book.isOpen())
+        cout << "Monte Carlo players open with the book " << book.path()
+            << " (from BATTLESHIP_BOOK)." << endl;
+    else
+        cout << "Monte Carlo players use no opening book"
+            << " (BATTLESHIP_BOOK is unset or not a book)." << endl;
+}
+
+// Print what to enter for choice 5 to watch a match's longest game again
+void reportLongestGame(const TournamentResult& result, string type1, string type2)
+{
+    if (result.longestGame == 0)
+        return;
+    bool type1First = (result.longestGame % 2 == 1);
+    cout << "The longest game took " << result.longestGameShots
+        << " shots; replay it with: "
+        << gameSeed(result.seed, result.longestGame) << " "
+        << (type1First ? type1 : type2) << " "
+        << (type1First ? type2 : type1) << endl;
+    reportBook(type1, type2);
+}
+
 int main()
 {
     const int NTRIALS = 10;
@@ -24,6 +55,7 @@ int main()
     cout << "  3.  A " << NTRIALS
         << "-game match between a mediocre and an awful player, with no pauses"
         << endl;
+    cout << "  5.  Replay a computer-vs-computer game from its seed" << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin, line);
@@ -54,53 +86,40 @@ int main()
     }
     else if (line[0] == '3')
     {
-        int nMediocreWins = 0;
-
-        for (int k = 1; k <= NTRIALS; k++)
-        {
-            cout << "============================= Game " << k
-                << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("awful", "Awful Audrey", g);
-            Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
-            Player* winner = (k % 2 == 1 ?
-                g.play(p1, p2, false) : g.play(p2, p1, false));
-            if (winner == p2)
-                nMediocreWins++;
-            delete p1;
-            delete p2;
-        }
-        cout << "The mediocre player won " << nMediocreWins << " out of "
+        TournamentResult result = runTournament(10, 10, addStandardShips,
+            "awful", "mediocre", NTRIALS);
+        cout << "The mediocre player won " << result.p2Wins << " out of "
             << NTRIALS << " games." << endl;
+        reportLongestGame(result, "awful", "mediocre");
         // We'd expect a mediocre player to win most of the games against
         // an awful player.  Similarly, a good player should outperform
         // a mediocre player.
     }
     else if (line[0] == '4')
     {
-        int nMediocreWins = 0;
-
-        for (int k = 1; k <= NTRIALS; k++)
+        TournamentResult result = runTournament(10, 10, addStandardShips,
+            "mediocre", "good", NTRIALS);
+        cout << "The good player won " << result.p2Wins << " out of "
+            << NTRIALS << " games." << endl;
+        reportLongestGame(result, "mediocre", "good");
+    }
+    else if (line[0] == '5')
+    {
+        unsigned long long seed;
+        string first;
+        string second;
+        cout << "Enter the seed and the types of the first and second players"
+            << " (e.g., 12345 mediocre good): ";
+        if (!(cin >> seed >> first >> second))
         {
-            cout << "============================= Game " << k
-                << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("mediocre", "Mediocre Man", g);
-            Player* p2 = createPlayer("good", "Genius", g);
-            Player* winner = (k % 2 == 1 ?
-                g.play(p1, p2, false) : g.play(p2, p1, false));
-            if (winner == p2)
-                nMediocreWins++;
-            delete p1;
-            delete p2;
+            cout << "You must enter a seed and two player types." << endl;
+            return 1;
         }
-        cout << "The good player won " << nMediocreWins << " out of "
-            << NTRIALS << " games." << endl;
-        // We'd expect a mediocre player to win most of the games against
-        // an awful player.  Similarly, a good player should outperform
-        // a mediocre player.
+        reportBook(first, second);
+        int winner = playSeededGame(10, 10, addStandardShips, first, second,
+            seed, true, &cout);
+        if (winner == 0)
+            cout << "That game could not be played." << endl;
     }
     else
     {
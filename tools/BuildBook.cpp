@@ -0,0 +1,153 @@
+// Builds the opening book read by OpeningBook.
+//
+// Build from the repository root together with every engine source, e.g.
+//     g++ -std=c++17 -O2 -pthread -I. tools/BuildBook.cpp
+//         $(ls *.cpp | grep -v main.cpp) -o battleship-book
+// and run
+//     battleship-book [--out opening.book] [--depth 8] [--samples 200000]
+//                     [--seed 1] [--game 10x10:5,4,3,3,2]...
+// Each --game adds a line for a board size and fleet; with none, the book
+// has the standard 10x10 fleet.  Every position of a line, up to depth
+// shots in, gets the shot a Monte Carlo player would choose with samples
+// layouts, so a book is worth building with far more samples than a player
+// could afford per move.
+
+#include "Game.h"
+#include "LayoutSampler.h"
+#include "OpeningBook.h"
+#include "globals.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Builder
+{
+    Builder(const Game& game, int nSamples, unsigned long long s)
+        : g(game), samples(nSamples), seed(s) {}
+    const Game& g;
+    int samples;
+    unsigned long long seed;
+    vector<OpeningBook::Node> nodes;
+    vector<double> counts;
+
+    // Add the nodes for the position sampler has seen and those after it,
+    // at most depth shots deep.  Returns the index of the position's node,
+    // or 0 if it has none.
+    uint32_t build(const LayoutSampler& sampler, int depth)
+    {
+        if (depth == 0)
+            return 0;
+        if (sampler.sample(mixSeed(seed + nodes.size()), samples, 0, 0, counts) == 0)
+            return 0;
+        int best = -1;
+        for (int cell = 0; cell < g.rows() * g.cols(); cell++)
+        {
+            if (!sampler.tried(Point(cell / g.cols(), cell % g.cols())) &&
+                    (best < 0 || counts[cell] > counts[best]))
+                best = cell;
+        }
+        if (best < 0)
+            return 0;
+        bool canHit = counts[best] > 0;
+        uint32_t index = nodes.size();
+        OpeningBook::Node node = { static_cast<uint32_t>(best), 0, 0 };
+        nodes.push_back(node);
+        Point p(best / g.cols(), best % g.cols());
+        LayoutSampler afterMiss(sampler);
+        afterMiss.record(p, false, false, -1);
+        uint32_t onMiss = build(afterMiss, depth - 1);
+        nodes[index].onMiss = onMiss;
+        //a hit that sinks a ship leaves the book, so only a plain hit goes on
+        if (canHit)
+        {
+            LayoutSampler afterHit(sampler);
+            afterHit.record(p, true, false, -1);
+            uint32_t onHit = build(afterHit, depth - 1);
+            nodes[index].onHit = onHit;
+        }
+        return index;
+    }
+};
+
+// Parse "RxC:l,l,..." into line
+bool parseGame(string spec, OpeningBook::Line& line)
+{
+    for (size_t k = 0; k < spec.size(); k++)
+    {
+        if (spec[k] == 'x' || spec[k] == ':' || spec[k] == ',')
+            spec[k] = ' ';
+    }
+    istringstream in(spec);
+    line.lengths.clear();
+    if (!(in >> line.rows >> line.cols))
+        return false;
+    int len;
+    while (in >> len)
+        line.lengths.push_back(len);
+    return in.eof() && !line.lengths.empty();
+}
+
+int main(int argc, char* argv[])
+{
+    string outPath = "opening.book";
+    int depth = 8;
+    int samples = 200000;
+    unsigned long long seed = 1;
+    vector<OpeningBook::Line> lines;
+    for (int k = 1; k < argc; k++)
+    {
+        string arg = argv[k];
+        OpeningBook::Line line;
+        if (arg == "--out" && k + 1 < argc)
+            outPath = argv[++k];
+        else if (arg == "--depth" && k + 1 < argc)
+            depth = atoi(argv[++k]);
+        else if (arg == "--samples" && k + 1 < argc)
+            samples = atoi(argv[++k]);
+        else if (arg == "--seed" && k + 1 < argc)
+            seed = strtoull(argv[++k], nullptr, 10);
+        else if (arg == "--game" && k + 1 < argc && parseGame(argv[++k], line))
+            lines.push_back(line);
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--out file] [--depth shots]"
+                << " [--samples n] [--seed n] [--game RxC:l,l,...]..." << endl;
+            return 2;
+        }
+    }
+    if (lines.empty())
+    {
+        OpeningBook::Line line;
+        parseGame("10x10:5,4,3,3,2", line);
+        lines.push_back(line);
+    }
+
+    for (size_t k = 0; k < lines.size(); k++)
+    {
+        OpeningBook::Line& line = lines[k];
+        Game g(line.rows, line.cols);
+        for (size_t s = 0; s < line.lengths.size(); s++)
+        {
+            if (!g.addShip(line.lengths[s], 'A' + s, "ship"))
+            {
+                cerr << "Cannot add a ship of length " << line.lengths[s] << endl;
+                return 1;
+            }
+        }
+        Builder builder(g, samples, seed);
+        builder.build(LayoutSampler(g), depth);
+        line.nodes.swap(builder.nodes);
+        cerr << line.rows << "x" << line.cols << ": " << line.nodes.size()
+            << " positions" << endl;
+    }
+    if (!OpeningBook::write(outPath, lines))
+    {
+        cerr << "Cannot write " << outPath << endl;
+        return 1;
+    }
+    return 0;
+}